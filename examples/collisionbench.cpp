@@ -0,0 +1,87 @@
+#include <astrum/astrum.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+// Measures how quickly `collision::SpatialHash` finds every overlapping pair
+// among moving objects, keeping the grid current either with `update` or by
+// calling `rebuild` each frame.
+// Doesn't need a window, so doesn't call `Astrum::init`.
+
+const float CELL_SIZE = 32.0f;
+
+struct World {
+	float size;
+	std::vector<Astrum::Rect> bounds;
+	std::vector<Astrum::Vec2> velocities;
+
+	explicit World(std::size_t count)
+		// the same density whatever the count
+		: size(std::sqrt(static_cast<float>(count)) * 40.0f),
+		bounds(count), velocities(count) {
+		Astrum::math::randomseed(1);
+		for (std::size_t i = 0; i < count; i++) {
+			float side = Astrum::math::randfloat(4.0, 16.0);
+			this->bounds[i] = Astrum::Rect(Astrum::math::randfloat(this->size),
+				Astrum::math::randfloat(this->size), side, side);
+			this->velocities[i] = Astrum::Vec2(Astrum::math::randfloat(-2.0, 2.0),
+				Astrum::math::randfloat(-2.0, 2.0));
+		}
+	}
+
+	void step() {
+		for (std::size_t i = 0; i < this->bounds.size(); i++) {
+			Astrum::Rect &rect = this->bounds[i];
+			Astrum::Vec2 &vel = this->velocities[i];
+			rect.x += vel.x;
+			rect.y += vel.y;
+			if (rect.x < 0.0f || rect.right() > this->size)
+				vel.x = -vel.x;
+			if (rect.y < 0.0f || rect.bottom() > this->size)
+				vel.y = -vel.y;
+		}
+	}
+};
+
+template <typename F>
+void measure(const char *name, std::size_t count, int frames, F sync) {
+	World world(count);
+	Astrum::collision::SpatialHash hash(CELL_SIZE, count);
+	hash.rebuild(world.bounds);
+	std::vector<Astrum::collision::Pair> pairs(count * 4);
+	std::size_t total = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; frame++) {
+		world.step();
+		sync(hash, world);
+		std::size_t found = hash.pairs(pairs);
+		if (found > pairs.size()) {
+			pairs.resize(found);
+			found = hash.pairs(pairs);
+		}
+		total += found;
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed = end - start;
+
+	Astrum::log::info("%zu objects, %s: %.2f ms/frame, %.0f pairs/frame, "
+		"%.2f M pairs/s\n", count, name, elapsed.count() * 1000.0 / frames,
+		static_cast<double>(total) / frames, total / elapsed.count() / 1e6);
+}
+
+int main() {
+	for (std::size_t count : { 10000, 100000 }) {
+		int frames = count > 10000 ? 30 : 300;
+		measure("update", count, frames, [](auto &hash, World &world) {
+			for (std::size_t i = 0; i < world.bounds.size(); i++)
+				hash.update(i, world.bounds[i]);
+		});
+		measure("rebuild", count, frames, [](auto &hash, World &world) {
+			hash.rebuild(world.bounds);
+		});
+	}
+
+	return 0;
+}
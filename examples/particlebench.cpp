@@ -0,0 +1,74 @@
+#include <astrum/astrum.hpp>
+
+#include <chrono>
+
+// Keeps 100k particles alive in a hidden window on SDL's software renderer,
+// and reports the time spent updating and drawing them.
+
+const std::size_t PARTICLES = 100000;
+const int FRAMES = 600;
+
+using Clock = std::chrono::steady_clock;
+
+Astrum::ParticleSystem particles(PARTICLES);
+int frame = 0;
+double updateTime = 0.0;
+double drawTime = 0.0;
+Clock::time_point startTime;
+
+double since(Clock::time_point start) {
+	std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+	return elapsed.count();
+}
+
+void load() {
+	particles.setPosition(400.0f, 300.0f);
+	particles.setAreaSpread(200.0f, 50.0f);
+	particles.setSpread(6.2832f);
+	particles.setSpeed(20.0f, 120.0f);
+	particles.setParticleLifetime(1.5f, 2.5f);
+	// enough to replace particles as quickly as they die
+	particles.setEmissionRate(PARTICLES / 2.0f);
+	particles.setLinearAcceleration(0.0f, 40.0f);
+	particles.setLinearDamping(0.5f);
+	particles.setSizes(3.0f, 1.0f);
+	particles.setColors(Astrum::Color(0xFFCC33), Astrum::Color(0xFF3300, 0));
+	particles.emit(PARTICLES);
+	startTime = Clock::now();
+}
+
+void update(double dt) {
+	auto start = Clock::now();
+	particles.update(dt);
+	updateTime += since(start);
+	if (++frame == FRAMES)
+		Astrum::quit();
+}
+
+void draw() {
+	auto start = Clock::now();
+	particles.draw();
+	drawTime += since(start);
+}
+
+int main() {
+	Astrum::Config conf;
+	conf.appName = "Astrum Particle Benchmark";
+	conf.windowWidth = 800;
+	conf.windowHeight = 600;
+	conf.headless = true;
+	conf.unlimitedFrameRate = true;
+
+	Astrum::init(conf);
+	Astrum::onstartup(load);
+	Astrum::ondraw(draw);
+	Astrum::run(update);
+
+	double total = since(startTime);
+	Astrum::log::info("%zu particles over %d frames: update %.2f ms, "
+		"draw %.2f ms, %.1f fps\n", particles.getCount(), frame,
+		updateTime / frame, drawTime / frame, frame / (total / 1000.0));
+
+	Astrum::exit();
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include <astrum/astrum.hpp>
+
+#include <chrono>
+#include <vector>
+
+// Plots a million points a frame in a hidden window on SDL's software
+// renderer: first in one colour, then in a few colours, then each in a
+// colour of its own, and reports the time spent drawing each way. A last
+// frame draws them one `graphics::point` call at a time, for comparison.
+
+const std::size_t POINTS = 1000000;
+const int FRAMES_PER_MODE = 60;
+
+using Clock = std::chrono::steady_clock;
+
+enum Mode { SINGLE, FEW_COLORS, MANY_COLORS, ONE_BY_ONE, MODES };
+const char *MODE_NAMES[] = {
+	"one colour", "8 colours", "many colours", "graphics::point"
+};
+
+std::vector<Astrum::Vec2> positions(POINTS);
+std::vector<Astrum::graphics::Point> fewColors(POINTS);
+std::vector<Astrum::graphics::Point> manyColors(POINTS);
+double drawTime[MODES] = { };
+int frames[MODES] = { };
+int frame = 0;
+
+double since(Clock::time_point start) {
+	std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+	return elapsed.count();
+}
+
+Mode currentMode() {
+	int mode = frame / FRAMES_PER_MODE;
+	return mode < ONE_BY_ONE ? static_cast<Mode>(mode) : ONE_BY_ONE;
+}
+
+void load() {
+	Astrum::math::RandomGenerator &rng = Astrum::math::getRandomGenerator();
+	for (std::size_t i = 0; i < POINTS; i++) {
+		positions[i] = Astrum::Vec2(rng.nextFloat() * 800.0f,
+			rng.nextFloat() * 600.0f);
+		std::uint32_t rgb = rng.next32() & 0xFFFFFF;
+		manyColors[i] = { positions[i], Astrum::Color(rgb) };
+		// the top bit of each channel, for 8 colours
+		fewColors[i] = { positions[i], Astrum::Color(rgb & 0x808080) };
+	}
+}
+
+void update(double) {
+	if (currentMode() == ONE_BY_ONE && frames[ONE_BY_ONE] > 0)
+		Astrum::quit();
+}
+
+void draw() {
+	Mode mode = currentMode();
+	auto start = Clock::now();
+	switch (mode) {
+	case SINGLE:
+		Astrum::graphics::points(positions, Astrum::Color(0xFFFFFF));
+		break;
+	case FEW_COLORS:
+		Astrum::graphics::points(fewColors);
+		break;
+	case MANY_COLORS:
+		Astrum::graphics::points(manyColors);
+		break;
+	default:
+		for (const Astrum::Vec2 &p : positions)
+			Astrum::graphics::point(static_cast<int>(p.x), static_cast<int>(p.y),
+				Astrum::Color(0xFFFFFF));
+		break;
+	}
+	drawTime[mode] += since(start);
+	frames[mode]++;
+	frame++;
+}
+
+int main() {
+	Astrum::Config conf;
+	conf.appName = "Astrum Points Benchmark";
+	conf.windowWidth = 800;
+	conf.windowHeight = 600;
+	conf.headless = true;
+	conf.unlimitedFrameRate = true;
+
+	Astrum::init(conf);
+	Astrum::onstartup(load);
+	Astrum::ondraw(draw);
+	Astrum::run(update);
+
+	for (int mode = 0; mode < MODES; mode++) {
+		if (frames[mode] == 0)
+			continue;
+		Astrum::log::info("%zu points, %s: %.2f ms a frame over %d frames\n",
+			POINTS, MODE_NAMES[mode], drawTime[mode] / frames[mode],
+			frames[mode]);
+	}
+
+	Astrum::exit();
+	return 0;
+}
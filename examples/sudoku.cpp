@@ -1,7 +1,8 @@
 #include <astrum/astrum.hpp>
 
 #include <cmath>
-#include <sstream>
+#include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <random>
@@ -445,23 +446,23 @@ void startup() {
 	memset(&puzzle.notes, 0, 81 * sizeof(short));
 }
 
-std::string prettyTime(double seconds) {
-	std::ostringstream out;
-	out.precision(2);
-	if (seconds > 60) {
-		int minutes = seconds / 60;
-		if (minutes > 60) {
-			int hours = minutes / 60;
-			out << std::to_string(hours) << "h";
-			minutes %= 60;
-			seconds -= (hours * 3600.0);
-		}
-		out << std::to_string(minutes) << "m";
+// formats into a caller-provided buffer, since it runs every frame
+void prettyTime(char *out, std::size_t size, double seconds) {
+	if (seconds <= 60) {
+		std::snprintf(out, size, "%.2fs", seconds);
+		return;
+	}
+	int minutes = seconds / 60;
+	if (minutes > 60) {
+		int hours = minutes / 60;
+		minutes %= 60;
+		seconds -= (hours * 3600.0);
 		seconds -= (minutes * 60.0);
-		out.precision(0);
+		std::snprintf(out, size, "%dh%dm%.0fs", hours, minutes, seconds);
+		return;
 	}
-	out << std::fixed << seconds << "s";
-	return out.str();
+	seconds -= (minutes * 60.0);
+	std::snprintf(out, size, "%dm%.0fs", minutes, seconds);
 }
 
 void draw() {
@@ -476,25 +477,19 @@ void draw() {
 			puzzleConfig.showErrors);
 	}
 
-	std::string formattedText;
-	std::string formattedTime = prettyTime(puzzle.time);
+	char time[32];
+	prettyTime(time, sizeof(time), puzzle.time);
+	Astrum::FixedString<64> formattedTime;
 	if (puzzle.won) {
 		// To-do: show "You finished the puzzle!" in black over the puzzle
-		formattedTime = Astrum::util::strformat("Time to complete: %s",
-			formattedTime.c_str());
-		Astrum::graphics::print(formattedTime,
-			gridSize + gridOffset * 2, gridOffset);
+		formattedTime.format("Time to complete: %s", time);
 	} else if (puzzle.quit) {
-		formattedTime = Astrum::util::strformat("Quit after %s",
-			formattedTime.c_str());
-		Astrum::graphics::print(formattedTime,
-			gridSize + gridOffset * 2, gridOffset);
+		formattedTime.format("Quit after %s", time);
 	} else {
-		formattedTime = Astrum::util::strformat("Time: %s",
-			formattedTime.c_str());
-		Astrum::graphics::print(formattedTime,
-			gridSize + gridOffset * 2, gridOffset);
+		formattedTime.format("Time: %s", time);
 	}
+	Astrum::graphics::print(formattedTime.c_str(),
+		gridSize + gridOffset * 2, gridOffset);
 
 	newGameButton.draw();
 
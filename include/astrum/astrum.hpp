@@ -7,6 +7,9 @@
 
 #include <filesystem>
 #include <functional>
+#include <string>
+#include <utility>
+#include <type_traits>
 
 #include "constants.hpp"
 #include "font.hpp"
@@ -24,6 +27,19 @@
 #include "sound.hpp"
 #include "audio.hpp"
 #include "system.hpp"
+#include "gamepad.hpp"
+#include "latency.hpp"
+#include "telemetry.hpp"
+#include "profile.hpp"
+#include "resources.hpp"
+#include "collision.hpp"
+#include "particles.hpp"
+#include "tilemap.hpp"
+#include "mesh.hpp"
+#include "polygon.hpp"
+#include "pixelbuffer.hpp"
+#include "event.hpp"
+#include "replay.hpp"
 
 namespace Astrum {
 
@@ -38,96 +54,257 @@ void run(std::function<void()> update);
 
 void quit();
 
-void onquit(std::function<void()> cb);
+/**
+ * @brief Registering event listeners
+ *
+ * Every `on*` function adds a listener to the matching registry in
+ * `Astrum::event` and returns a token that can be used to remove it again.
+ * Several listeners may be registered to the same event; ones with a higher
+ * `priority` are called first, and ones with equal priority are called in the
+ * order they were added.
+ *
+ * Callbacks may take a prefix of the event's arguments (e.g. a `keypressed`
+ * listener can take just the `Key`); the adapter for that is stored along with
+ * the callback itself, so dispatching is always a single indirect call.
+ */
+template <typename F>
+ListenerToken onquit(F &&cb, int priority = 0) {
+	return event::quit.add(std::forward<F>(cb), priority);
+}
 
-void ondraw(std::function<void()> cb);
+template <typename F>
+ListenerToken ondraw(F &&cb, int priority = 0) {
+	return event::draw.add(std::forward<F>(cb), priority);
+}
 
-void onstartup(std::function<void()> cb);
+template <typename F>
+ListenerToken onstartup(F &&cb, int priority = 0) {
+	return event::startup.add(std::forward<F>(cb), priority);
+}
 
-void onkeypressed(std::function<void(Key, KeyMod, bool)> cb);
-/**
- * @overload
- */
-void onkeypressed(std::function<void(Key, KeyMod)> cb);
-/**
- * @overload
- */
-void onkeypressed(std::function<void(Key)> cb);
+template <typename F>
+ListenerToken onkeypressed(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, Key, KeyMod, bool>) {
+		return event::keypressed.add(std::forward<F>(cb), priority);
+	} else if constexpr (std::is_invocable_v<F &, Key, KeyMod>) {
+		return event::keypressed.add([cb = std::forward<F>(cb)](Key k,
+			KeyMod m, bool) mutable { cb(k, m); }, priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, Key>,
+			"keypressed listeners take (Key[, KeyMod[, bool]])");
+		return event::keypressed.add([cb = std::forward<F>(cb)](Key k,
+			KeyMod, bool) mutable { cb(k); }, priority);
+	}
+}
 
-void onkeyreleased(std::function<void(Key)> cb);
+template <typename F>
+ListenerToken onkeyreleased(F &&cb, int priority = 0) {
+	return event::keyreleased.add(std::forward<F>(cb), priority);
+}
 
-void onresize(std::function<void(int, int)> cb);
+template <typename F>
+ListenerToken onresize(F &&cb, int priority = 0) {
+	return event::resize.add(std::forward<F>(cb), priority);
+}
 
-void onvisible(std::function<void(bool)> cb);
+template <typename F>
+ListenerToken onvisible(F &&cb, int priority = 0) {
+	return event::visible.add(std::forward<F>(cb), priority);
+}
 
-void onfocus(std::function<void(bool)> cb);
+template <typename F>
+ListenerToken onfocus(F &&cb, int priority = 0) {
+	return event::focus.add(std::forward<F>(cb), priority);
+}
 
-void onmoved(std::function<void(int, int)> cb);
+template <typename F>
+ListenerToken onmoved(F &&cb, int priority = 0) {
+	return event::moved.add(std::forward<F>(cb), priority);
+}
 
-void ontextinput(std::function<void(std::string)> cb);
+template <typename F>
+ListenerToken ontextinput(F &&cb, int priority = 0) {
+	return event::textinput.add(std::forward<F>(cb), priority);
+}
 
-void ontextedited(std::function<void(std::string, int, int)> cb);
-/**
- * @overload
- */
-void ontextedited(std::function<void(std::string, int)> cb);
-/**
- * @overload
- */
-void ontextedited(std::function<void(std::string)> cb);
+template <typename F>
+ListenerToken ontextedited(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, const std::string &, int, int>) {
+		return event::textedited.add(std::forward<F>(cb), priority);
+	} else if constexpr (std::is_invocable_v<F &, const std::string &, int>) {
+		return event::textedited.add([cb = std::forward<F>(cb)](
+			const std::string &text, int start, int) mutable {
+			cb(text, start);
+		}, priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, const std::string &>,
+			"textedited listeners take (std::string[, int[, int]])");
+		return event::textedited.add([cb = std::forward<F>(cb)](
+			const std::string &text, int, int) mutable {
+			cb(text);
+		}, priority);
+	}
+}
 
-void onmousemoved(std::function<void(int, int, int, int)> cb);
-/**
- * @overload
- */
-void onmousemoved(std::function<void(int, int)> cb);
+template <typename F>
+ListenerToken onmousemoved(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, int, int, int, int>) {
+		return event::mousemoved.add(std::forward<F>(cb), priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, int, int>,
+			"mousemoved listeners take (int, int[, int, int])");
+		return event::mousemoved.add([cb = std::forward<F>(cb)](int x,
+			int y, int, int) mutable { cb(x, y); }, priority);
+	}
+}
 
-void onmousepressed(std::function<void(MouseButton, int, int, int)> cb);
 /**
- * @overload
+ * @brief Receive every mouse motion sample of a frame at once.
+ *
+ * Only called while raw motion is enabled; see `mouse::setRawMotion`.
  */
-void onmousepressed(std::function<void(MouseButton, int, int)> cb);
-/**
- * @overload
- */
-void onmousepressed(std::function<void(MouseButton)> cb);
+template <typename F>
+ListenerToken onmousemotionraw(F &&cb, int priority = 0) {
+	return event::mousemotionraw.add(std::forward<F>(cb), priority);
+}
 
-void onmousereleased(std::function<void(MouseButton, int, int, int)> cb);
-/**
- * @overload
- */
-void onmousereleased(std::function<void(MouseButton, int, int)> cb);
-/**
- * @overload
- */
-void onmousereleased(std::function<void(MouseButton)> cb);
+template <typename F>
+ListenerToken onmousepressed(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, MouseButton, int, int, int>) {
+		return event::mousepressed.add(std::forward<F>(cb), priority);
+	} else if constexpr (std::is_invocable_v<F &, MouseButton, int, int>) {
+		return event::mousepressed.add([cb = std::forward<F>(cb)](
+			MouseButton button, int x, int y, int) mutable {
+			cb(button, x, y);
+		}, priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, MouseButton>,
+			"mousepressed listeners take (MouseButton[, int, int[, int]])");
+		return event::mousepressed.add([cb = std::forward<F>(cb)](
+			MouseButton button, int, int, int) mutable {
+			cb(button);
+		}, priority);
+	}
+}
 
-void onwheelmoved(std::function<void(int, int)> cb);
+template <typename F>
+ListenerToken onmousereleased(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, MouseButton, int, int, int>) {
+		return event::mousereleased.add(std::forward<F>(cb), priority);
+	} else if constexpr (std::is_invocable_v<F &, MouseButton, int, int>) {
+		return event::mousereleased.add([cb = std::forward<F>(cb)](
+			MouseButton button, int x, int y, int) mutable {
+			cb(button, x, y);
+		}, priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, MouseButton>,
+			"mousereleased listeners take (MouseButton[, int, int[, int]])");
+		return event::mousereleased.add([cb = std::forward<F>(cb)](
+			MouseButton button, int, int, int) mutable {
+			cb(button);
+		}, priority);
+	}
+}
 
-void onmousefocus(std::function<void(bool)> cb);
+template <typename F>
+ListenerToken onwheelmoved(F &&cb, int priority = 0) {
+	return event::wheelmoved.add(std::forward<F>(cb), priority);
+}
 
-void onfiledropped(std::function<void(std::filesystem::path)> cb);
-/**
- * @overload
- */
-void onfiledropped(std::function<void(std::string)> cb);
+template <typename F>
+ListenerToken onmousefocus(F &&cb, int priority = 0) {
+	return event::mousefocus.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken onfiledropped(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, const std::filesystem::path &>) {
+		return event::filedropped.add(std::forward<F>(cb), priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, const std::string &>,
+			"filedropped listeners take a path or a string");
+		return event::filedropped.add([cb = std::forward<F>(cb)](
+			const std::filesystem::path &p) mutable {
+			cb(p.string());
+		}, priority);
+	}
+}
+
+template <typename F>
+ListenerToken ondirectorydropped(F &&cb, int priority = 0) {
+	if constexpr (std::is_invocable_v<F &, const std::filesystem::path &>) {
+		return event::directorydropped.add(std::forward<F>(cb), priority);
+	} else {
+		static_assert(std::is_invocable_v<F &, const std::string &>,
+			"directorydropped listeners take a path or a string");
+		return event::directorydropped.add([cb = std::forward<F>(cb)](
+			const std::filesystem::path &p) mutable {
+			cb(p.string());
+		}, priority);
+	}
+}
+
+template <typename F>
+ListenerToken ongamepadadded(F &&cb, int priority = 0) {
+	return event::gamepadadded.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken ongamepadremoved(F &&cb, int priority = 0) {
+	return event::gamepadremoved.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken ongamepadaxis(F &&cb, int priority = 0) {
+	return event::gamepadaxis.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken ongamepadpressed(F &&cb, int priority = 0) {
+	return event::gamepadpressed.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken ongamepadreleased(F &&cb, int priority = 0) {
+	return event::gamepadreleased.add(std::forward<F>(cb), priority);
+}
 
-void ondirectorydropped(std::function<void(std::filesystem::path)> cb);
 /**
- * @overload
+ * @brief Raw joystick events
+ *
+ * Joysticks are identified by their SDL instance ID. Gamepads send these as
+ * well as the `ongamepad*` events. Up to 8 joysticks that aren't gamepads,
+ * like flight sticks and wheels, are opened as they are plugged in.
  */
-void ondirectorydropped(std::function<void(std::string)> cb);
-
-// TODO
-// void ongamepadaxis();
-// void ongamepadpressed();
-// void ongamepadreleased();
-// void onjoystickadded();
-// void onjoystickaxis();
-// void onjoystickhat();
-// void onjoystickpressed();
-// void onjoystickreleased();
-// void onjoystickremoved();
+template <typename F>
+ListenerToken onjoystickadded(F &&cb, int priority = 0) {
+	return event::joystickadded.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken onjoystickremoved(F &&cb, int priority = 0) {
+	return event::joystickremoved.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken onjoystickaxis(F &&cb, int priority = 0) {
+	return event::joystickaxis.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken onjoystickhat(F &&cb, int priority = 0) {
+	return event::joystickhat.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken onjoystickpressed(F &&cb, int priority = 0) {
+	return event::joystickpressed.add(std::forward<F>(cb), priority);
+}
+
+template <typename F>
+ListenerToken onjoystickreleased(F &&cb, int priority = 0) {
+	return event::joystickreleased.add(std::forward<F>(cb), priority);
+}
 
 } // namespace Astrum
 
@@ -0,0 +1,153 @@
+#ifndef INCLUDE_ASTRUM_COLLISION
+#define INCLUDE_ASTRUM_COLLISION
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "constants.hpp"
+#include "math.hpp"
+#include "util.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Finding what overlaps what, among many objects
+ */
+namespace collision {
+
+	using Id = std::uint32_t;
+
+	/**
+	 * @brief Two overlapping objects, with `a < b`.
+	 */
+	struct Pair {
+		Id a;
+		Id b;
+	};
+
+	struct RayHit {
+		Id id;
+		// along the ray, in multiples of the direction's length
+		float distance;
+	};
+
+	/**
+	 * @brief A uniform grid of square cells over an unbounded plane
+	 *
+	 * Objects are axis-aligned rects, identified by ids the caller picks,
+	 * usually their indices in the caller's own arrays. Cells are hashed
+	 * into a fixed number of buckets, each a linked list threaded through
+	 * one flat array; `rebuild` lays every bucket out contiguously, and
+	 * `update` relinks only objects that changed cells.
+	 *
+	 * Queries write into a caller-provided span and return how many results
+	 * there were, which is more than were written when the span is too
+	 * small. They don't allocate. They do share scratch state, so one hash
+	 * must not be queried from several threads at once.
+	 *
+	 * Cells about the size of a typical object work best.
+	 */
+	class SpatialHash {
+	private:
+		struct Node {
+			Id id;
+			std::int32_t cx;
+			std::int32_t cy;
+			// -1 ends the list
+			std::int32_t next;
+		};
+		struct CellRange {
+			std::int32_t minX;
+			std::int32_t minY;
+			std::int32_t maxX;
+			std::int32_t maxY;
+		};
+
+		float cellSize;
+		float invCellSize;
+		std::uint32_t bucketMask;
+		std::vector<std::int32_t> heads;
+		std::vector<Node> nodes;
+		// scratch for the counting sort in `rebuild`
+		std::vector<std::int32_t> offsets;
+		std::int32_t freeNodes = -1;
+		std::vector<Rect> bounds;
+		std::vector<CellRange> ranges;
+		std::vector<std::uint8_t> present;
+		std::size_t count = 0;
+		// stamped with `query` when an object is reported, to skip objects
+		// seen in an earlier cell of the same query
+		mutable std::vector<std::uint32_t> stamps;
+		mutable std::uint32_t query = 0;
+
+		CellRange cellsOf(const Rect &rect) const;
+		std::uint32_t bucketOf(std::int32_t cx, std::int32_t cy) const;
+		void link(Id id, const CellRange &range);
+		void unlink(Id id, const CellRange &range);
+		std::uint32_t nextQuery() const;
+		template <typename F>
+		void visitCell(std::int32_t cx, std::int32_t cy, std::uint32_t stamp,
+			F &&found) const;
+		template <typename F>
+		void visit(const CellRange &range, F &&found) const;
+
+	public:
+		/**
+		 * @brief Rounds `buckets` up to a power of two.
+		 */
+		explicit SpatialHash(float cellSize, std::size_t buckets = 4096);
+
+		/**
+		 * @brief Replace every object with `objects`, with ids being
+		 * indices into it.
+		 */
+		void rebuild(Span<const Rect> objects);
+		void clear();
+
+		void insert(Id id, const Rect &rect);
+		/**
+		 * @brief Move an object, inserting it if it isn't present.
+		 *
+		 * Cheap when it stays within the same cells.
+		 */
+		void update(Id id, const Rect &rect);
+		void remove(Id id);
+		bool contains(Id id) const;
+		Rect getBounds(Id id) const;
+		std::size_t size() const;
+		float getCellSize() const;
+
+		/**
+		 * @brief Objects overlapping `area`.
+		 */
+		std::size_t queryRect(const Rect &area, Span<Id> out) const;
+		/**
+		 * @brief Objects overlapping a circle.
+		 */
+		std::size_t queryCircle(Vec2 center, float radius, Span<Id> out) const;
+		/**
+		 * @brief Objects containing `point`.
+		 */
+		std::size_t queryPoint(Vec2 point, Span<Id> out) const;
+		/**
+		 * @brief Objects hit by the segment from `origin` to
+		 * `origin + dir * maxDistance`.
+		 *
+		 * The hits written are sorted nearest first. When `out` is too small,
+		 * the nearest cells are searched first, but the hits beyond its
+		 * size are lost unsorted.
+		 */
+		std::size_t queryRay(Vec2 origin, Vec2 dir, float maxDistance,
+			Span<RayHit> out) const;
+		/**
+		 * @brief Every pair of overlapping objects, each reported once.
+		 */
+		std::size_t pairs(Span<Pair> out) const;
+	};
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_COLLISION
@@ -61,6 +61,19 @@ public:
 	// 2. In theory, I could sometime extend this to allow, for example, an
 	// OpenGL window, or something similar, instead of just an SDL window.
 	void *existingWindow       = nullptr;
+	// Record every input event, frame time and random seed to this file
+	// (see `replay.hpp`).
+	std::filesystem::path recordInput = "";
+	// Play back a file written through `recordInput` instead of reading
+	// real input.
+	std::filesystem::path replayInput = "";
+	// Run without showing a window, using SDL's dummy video driver.
+	bool headless              = false;
+	// Don't wait for vsync or sleep between frames.
+	bool unlimitedFrameRate    = false;
+	// Present each frame right after `draw` instead of at the start of the
+	// next frame, which cuts a frame of input latency.
+	bool presentAfterDraw      = false;
 };
 
 }; // namespace Astrum
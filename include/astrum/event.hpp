@@ -0,0 +1,325 @@
+#ifndef INCLUDE_ASTRUM_EVENT
+#define INCLUDE_ASTRUM_EVENT
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <filesystem>
+
+#include "constants.hpp"
+#include "util.hpp"
+#include "key.hpp"
+#include "mouse.hpp"
+#include "gamepad.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief A type-erased callable with inline storage.
+ *
+ * Holds any callable that can be invoked as `void(Args...)`. Callables no
+ * larger than `INLINE_SIZE` bytes (function pointers, lambdas capturing a few
+ * values) are stored inside the object itself, so registering them never
+ * allocates; larger ones are moved to the heap. Invoking goes through a single
+ * function pointer, with no further indirection.
+ */
+template <typename... Args>
+class Callback {
+public:
+	static constexpr std::size_t INLINE_SIZE = 4 * sizeof(void *);
+
+private:
+	enum class Op { move, destroy };
+
+	alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+	void (*invoker)(void *, Args...) = nullptr;
+	void (*manager)(Op, void *, void *) = nullptr;
+
+	template <typename F>
+	static constexpr bool fitsInline = sizeof(F) <= INLINE_SIZE
+		&& alignof(F) <= alignof(std::max_align_t)
+		&& std::is_nothrow_move_constructible_v<F>;
+
+	template <typename F>
+	static void invokeInline(void *self, Args... args) {
+		(*std::launder(reinterpret_cast<F *>(self)))(std::forward<Args>(args)...);
+	}
+	template <typename F>
+	static void manageInline(Op op, void *dst, void *src) {
+		F *from = std::launder(reinterpret_cast<F *>(src));
+		if (op == Op::move)
+			::new (dst) F(std::move(*from));
+		from->~F();
+	}
+
+	template <typename F>
+	static void invokeHeap(void *self, Args... args) {
+		(**reinterpret_cast<F **>(self))(std::forward<Args>(args)...);
+	}
+	template <typename F>
+	static void manageHeap(Op op, void *dst, void *src) {
+		F **from = reinterpret_cast<F **>(src);
+		if (op == Op::move)
+			*reinterpret_cast<F **>(dst) = *from;
+		else
+			delete *from;
+		*from = nullptr;
+	}
+
+	void reset() {
+		if (this->manager != nullptr)
+			this->manager(Op::destroy, nullptr, this->storage);
+		this->invoker = nullptr;
+		this->manager = nullptr;
+	}
+
+public:
+	Callback() = default;
+	template <typename F, typename = std::enable_if_t<
+		!std::is_same_v<std::decay_t<F>, Callback>>>
+	Callback(F &&func) {
+		using Fn = std::decay_t<F>;
+		if constexpr (fitsInline<Fn>) {
+			::new (static_cast<void *>(this->storage)) Fn(std::forward<F>(func));
+			this->invoker = invokeInline<Fn>;
+			this->manager = manageInline<Fn>;
+		} else {
+			*reinterpret_cast<Fn **>(this->storage) = new Fn(std::forward<F>(func));
+			this->invoker = invokeHeap<Fn>;
+			this->manager = manageHeap<Fn>;
+		}
+	}
+	Callback(const Callback &src) = delete;
+	Callback(Callback &&src) noexcept : invoker(src.invoker),
+		manager(src.manager) {
+		if (this->manager != nullptr)
+			this->manager(Op::move, this->storage, src.storage);
+		src.invoker = nullptr;
+		src.manager = nullptr;
+	}
+	Callback &operator=(const Callback &src) = delete;
+	Callback &operator=(Callback &&src) noexcept {
+		if (this == &src)
+			return *this;
+		this->reset();
+		this->invoker = src.invoker;
+		this->manager = src.manager;
+		if (this->manager != nullptr)
+			this->manager(Op::move, this->storage, src.storage);
+		src.invoker = nullptr;
+		src.manager = nullptr;
+		return *this;
+	}
+	~Callback() {
+		this->reset();
+	}
+
+	explicit operator bool() const {
+		return this->invoker != nullptr;
+	}
+	void operator()(Args... args) {
+		this->invoker(this->storage, std::forward<Args>(args)...);
+	}
+};
+
+/**
+ * @brief Common base of every listener registry.
+ *
+ * Only exists so that a `ListenerToken` can unsubscribe without knowing the
+ * argument types of the event it is registered to.
+ */
+class ListenersBase {
+public:
+	virtual ~ListenersBase() = default;
+	virtual void remove(std::size_t id) = 0;
+};
+
+/**
+ * @brief Handle for a registered listener.
+ *
+ * Returned by every `on*` function; call `remove()` to unsubscribe. Dropping
+ * the token does *not* unsubscribe the listener.
+ */
+class ListenerToken {
+private:
+	ListenersBase *owner = nullptr;
+	std::size_t id = 0;
+
+public:
+	ListenerToken() = default;
+	ListenerToken(ListenersBase *owner, std::size_t id)
+		: owner(owner), id(id) { }
+
+	/**
+	 * @brief Unsubscribe the listener.
+	 *
+	 * Safe to call more than once, and from inside the listener itself.
+	 */
+	void remove() {
+		if (this->owner != nullptr)
+			this->owner->remove(this->id);
+		this->owner = nullptr;
+	}
+	bool valid() const {
+		return this->owner != nullptr;
+	}
+};
+
+/**
+ * @brief An ordered list of listeners for one event.
+ *
+ * Listeners with a higher priority are called first; listeners with equal
+ * priority are called in the order they were added. Listeners may be added or
+ * removed while the event is being dispatched; additions take effect from the
+ * next dispatch, removals immediately.
+ */
+template <typename... Args>
+class Listeners : public ListenersBase {
+private:
+	struct Entry {
+		Callback<Args...> cb;
+		int priority;
+		std::size_t id;
+		bool live;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<Entry> pending;
+	std::size_t nextId = 1;
+	int dispatching = 0;
+	bool hasDead = false;
+
+	void insert(Entry &&entry) {
+		auto pos = std::upper_bound(this->entries.begin(),
+			this->entries.end(), entry.priority,
+			[](int priority, const Entry &e) { return priority > e.priority; });
+		this->entries.insert(pos, std::move(entry));
+	}
+	void commit() {
+		if (this->hasDead) {
+			this->entries.erase(std::remove_if(this->entries.begin(),
+				this->entries.end(),
+				[](const Entry &e) { return !e.live; }),
+				this->entries.end());
+			this->hasDead = false;
+		}
+		for (auto &entry : this->pending)
+			this->insert(std::move(entry));
+		this->pending.clear();
+	}
+
+public:
+	template <typename F>
+	ListenerToken add(F &&cb, int priority = 0) {
+		std::size_t id = this->nextId++;
+		Entry entry { Callback<Args...>(std::forward<F>(cb)), priority, id, true };
+		if (this->dispatching)
+			this->pending.push_back(std::move(entry));
+		else
+			this->insert(std::move(entry));
+		return ListenerToken(this, id);
+	}
+
+	void remove(std::size_t id) override {
+		auto match = [id](const Entry &e) { return e.id == id; };
+		auto it = std::find_if(this->pending.begin(), this->pending.end(), match);
+		if (it != this->pending.end()) {
+			this->pending.erase(it);
+			return;
+		}
+		it = std::find_if(this->entries.begin(), this->entries.end(), match);
+		if (it == this->entries.end())
+			return;
+		if (this->dispatching) {
+			// the callable may be the one currently running
+			it->live = false;
+			this->hasDead = true;
+		} else {
+			this->entries.erase(it);
+		}
+	}
+
+	void clear() {
+		if (this->dispatching) {
+			for (auto &entry : this->entries)
+				entry.live = false;
+			this->hasDead = true;
+		} else {
+			this->entries.clear();
+		}
+		this->pending.clear();
+	}
+
+	bool empty() const {
+		return this->entries.empty() && this->pending.empty();
+	}
+	std::size_t size() const {
+		return this->entries.size() + this->pending.size();
+	}
+
+	void dispatch(Args... args) {
+		if (this->entries.empty())
+			return;
+		this->dispatching++;
+		// `entries` never reallocates during dispatch; additions go to
+		// `pending` and removals only mark the entry dead
+		const std::size_t count = this->entries.size();
+		for (std::size_t i = 0; i < count; i++) {
+			Entry &entry = this->entries[i];
+			if (entry.live)
+				entry.cb(args...);
+		}
+		this->dispatching--;
+		if (!this->dispatching && (this->hasDead || !this->pending.empty()))
+			this->commit();
+	}
+};
+
+/**
+ * @brief Listener registries for every built-in event.
+ *
+ * These are what the `on*` functions register into; they can also be used
+ * directly, e.g. `event::keypressed.clear()`.
+ */
+namespace event {
+
+	extern Listeners<> quit;
+	extern Listeners<> draw;
+	extern Listeners<> startup;
+	extern Listeners<int, int> resize;
+	extern Listeners<bool> visible;
+	extern Listeners<bool> focus;
+	extern Listeners<int, int> moved;
+	extern Listeners<Key, KeyMod, bool> keypressed;
+	extern Listeners<Key> keyreleased;
+	extern Listeners<const std::string &> textinput;
+	extern Listeners<const std::string &, int, int> textedited;
+	extern Listeners<int, int, int, int> mousemoved;
+	extern Listeners<Span<const MouseMotion>> mousemotionraw;
+	extern Listeners<MouseButton, int, int, int> mousepressed;
+	extern Listeners<MouseButton, int, int, int> mousereleased;
+	extern Listeners<int, int> wheelmoved;
+	extern Listeners<bool> mousefocus;
+	extern Listeners<const std::filesystem::path &> filedropped;
+	extern Listeners<const std::filesystem::path &> directorydropped;
+	extern Listeners<int> gamepadadded;
+	extern Listeners<int> gamepadremoved;
+	extern Listeners<int, GamepadAxis, float> gamepadaxis;
+	extern Listeners<int, GamepadButton> gamepadpressed;
+	extern Listeners<int, GamepadButton> gamepadreleased;
+	extern Listeners<int> joystickadded;
+	extern Listeners<int> joystickremoved;
+	extern Listeners<int, int, float> joystickaxis;
+	extern Listeners<int, int, int> joystickhat;
+	extern Listeners<int, int> joystickpressed;
+	extern Listeners<int, int> joystickreleased;
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_EVENT
@@ -43,12 +43,24 @@ public:
 	 * @overload
 	 */
 	std::shared_ptr<struct FontData> getData();
-	Image renderText(std::string text) const;
+	Image renderText(const char *text) const;
 	/**
 	 * @overload
 	 */
-	Image renderText(std::string text, Color color) const;
-	std::tuple<int, int> textSize(std::string text) const;
+	Image renderText(const char *text, Color color) const;
+	/**
+	 * @overload
+	 */
+	Image renderText(const std::string &text) const;
+	/**
+	 * @overload
+	 */
+	Image renderText(const std::string &text, Color color) const;
+	std::tuple<int, int> textSize(const char *text) const;
+	/**
+	 * @overload
+	 */
+	std::tuple<int, int> textSize(const std::string &text) const;
 	Color getColor() const;
 	void setColor(Color col);
 	TextAlign getAlign() const;
@@ -0,0 +1,97 @@
+#ifndef INCLUDE_ASTRUM_GAMEPAD
+#define INCLUDE_ASTRUM_GAMEPAD
+
+#include <cstdint>
+#include <string>
+
+#include "constants.hpp"
+
+namespace Astrum {
+
+enum class GamepadAxis {
+	LEFT_X, LEFT_Y, RIGHT_X, RIGHT_Y, TRIGGER_LEFT, TRIGGER_RIGHT
+};
+
+enum class GamepadButton {
+	A, B, X, Y, BACK, GUIDE, START, LEFT_STICK, RIGHT_STICK, LEFT_SHOULDER,
+	RIGHT_SHOULDER, DPAD_UP, DPAD_DOWN, DPAD_LEFT, DPAD_RIGHT
+};
+
+/**
+ * @brief Snapshot of one gamepad, taken once per frame.
+ *
+ * Refreshed right before `update` is called, so reading it is just a memory
+ * load. Sticks range from -1 to 1 and triggers from 0 to 1, with the deadzone
+ * already applied. `buttons` has bit `n` set while `GamepadButton` `n` is
+ * held; `pressed` and `released` hold the buttons that went down or up since
+ * the previous frame, even if they were tapped within a single frame.
+ */
+struct GamepadState {
+	static constexpr int AXIS_COUNT = 6;
+
+	float axes[AXIS_COUNT] = { };
+	std::uint32_t buttons = 0;
+	std::uint32_t pressed = 0;
+	std::uint32_t released = 0;
+	bool connected = false;
+
+	float axis(GamepadAxis which) const {
+		return this->axes[static_cast<int>(which)];
+	}
+	bool isdown(GamepadButton button) const {
+		return this->buttons & (1u << static_cast<int>(button));
+	}
+	bool wasPressed(GamepadButton button) const {
+		return this->pressed & (1u << static_cast<int>(button));
+	}
+	bool wasReleased(GamepadButton button) const {
+		return this->released & (1u << static_cast<int>(button));
+	}
+};
+
+/**
+ * @brief Contains functions for reading gamepads
+ *
+ * Gamepads are assigned to a fixed slot (`0` to `MAX_GAMEPADS - 1`) when they
+ * are connected and keep it until they are disconnected. The state of every
+ * slot can be read at any time through `getState`; the `ongamepad*` callbacks
+ * are optional.
+ */
+namespace gamepad {
+
+	constexpr int MAX_GAMEPADS = 8;
+
+	/**
+	 * @brief The number of connected gamepads.
+	 */
+	int getCount();
+	bool isConnected(int index);
+	/**
+	 * @brief The state of the gamepad in slot `index` as of this frame.
+	 *
+	 * Disconnected and out-of-range slots read as all zeroes.
+	 */
+	const GamepadState &getState(int index);
+	bool isdown(int index, GamepadButton button);
+	float getAxis(int index, GamepadAxis axis);
+	/**
+	 * @brief The controller's name, or empty if there isn't one.
+	 *
+	 * Gamepads in a replay are rebuilt from the recording and have no name.
+	 */
+	std::string getName(int index);
+
+	/**
+	 * @brief Get the axis deadzone.
+	 *
+	 * Axis values with a magnitude below the deadzone read as 0, and the
+	 * remaining range is rescaled to start from 0. Defaults to 0.15.
+	 */
+	float getDeadzone();
+	void setDeadzone(float deadzone);
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_GAMEPAD
@@ -3,17 +3,91 @@
 
 #include <vector>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <tuple>
 
 #include "constants.hpp"
 #include "font.hpp"
 #include "image.hpp"
+#include "math.hpp"
+#include "util.hpp"
 
 namespace Astrum {
 
 namespace graphics {
 
+	/**
+	 * @brief Where and how `draw` puts an image, for that draw alone
+	 *
+	 * The image is sheared, scaled and rotated about `origin`, a point on
+	 * the image in its own pixels, which then lands on `position`. Flips
+	 * mirror the image in place, and `tint` multiplies its colours.
+	 * `source` draws only part of the image, in pixels; whatever of it lies
+	 * outside the image is left out.
+	 */
+	struct DrawParams {
+		Vec2 position;
+		// in radians, clockwise
+		float rotation = 0.0f;
+		Vec2 scale = Vec2(1.0f, 1.0f);
+		Vec2 origin;
+		Vec2 shear;
+		bool flipX = false;
+		bool flipY = false;
+		Color tint = Color(0xFF, 0xFF, 0xFF, 0xFF);
+		std::optional<Rect> source;
+
+		DrawParams() = default;
+		DrawParams(float x, float y, float rotation = 0.0f, float sx = 1.0f,
+			float sy = 1.0f, float ox = 0.0f, float oy = 0.0f)
+			: position(x, y), rotation(rotation), scale(sx, sy),
+			origin(ox, oy) { }
+
+		/**
+		 * @brief The transform from image pixels to where they're drawn,
+		 * before the graphics transform.
+		 */
+		Mat3 getTransform() const;
+	};
+
+	/**
+	 * @brief Rendering work done since the start of the frame.
+	 *
+	 * `drawCalls` counts everything submitted to the renderer, including the
+	 * `gfxPrimitives` drawn through SDL2_gfx. `textureCreations` counts new
+	 * textures, and `textureUploads` copies of pixels from memory to a
+	 * texture. `textRasterizations` counts strings rendered by a font.
+	 * `culled` counts draws skipped for landing outside the view, which
+	 * aren't counted as draw calls.
+	 */
+	struct Stats {
+		std::uint32_t drawCalls = 0;
+		std::uint32_t gfxPrimitives = 0;
+		std::uint32_t textureCreations = 0;
+		std::uint32_t textureUploads = 0;
+		std::uint32_t textRasterizations = 0;
+		std::uint32_t culled = 0;
+	};
+
+	/**
+	 * @brief The counters for the current frame so far.
+	 *
+	 * The counters are reset at the start of every frame, before events are
+	 * handled.
+	 */
+	Stats getStats();
+	void resetStats();
+	/**
+	 * @brief Get the per-frame limits checked on debug builds.
+	 *
+	 * On debug builds, a frame that goes over any non-zero field of the
+	 * budget logs an error and fails an assertion. Release builds never
+	 * check. Defaults to all zeroes, meaning no limits.
+	 */
+	Stats getStatsBudget();
+	void setStatsBudget(Stats budget);
+
 	Color getBackgroundColor();
 	void setBackgroundColor(Color color);
 	int getLineThickness();
@@ -36,32 +110,154 @@ namespace graphics {
 	void ellipse(int x, int y, int rx, int ry, Color col, bool filled = false);
 	void ellipseFilled(int x, int y, int rx, int ry);
 	void ellipseFilled(int x, int y, int rx, int ry, Color col);
-	void polygon(const std::vector<int> vertices, bool filled = false);
-	void polygon(const std::vector<int> vertices, Color col, bool filled = false);
-	void polygonFilled(const std::vector<int> vertices);
-	void polygonFilled(const std::vector<int> vertices, Color col);
+	void polygon(const std::vector<int> &vertices, bool filled = false);
+	void polygon(const std::vector<int> &vertices, Color col, bool filled = false);
+	void polygonFilled(const std::vector<int> &vertices);
+	void polygonFilled(const std::vector<int> &vertices, Color col);
+	/**
+	 * @brief A polygon through `points`, drawn without copying them.
+	 *
+	 * Outlines are one draw call, like `polyline`. Fills are redone every
+	 * call; a `Polygon` keeps its fill between draws.
+	 */
+	void polygon(Span<const Vec2> points, bool filled = false);
+	void polygon(Span<const Vec2> points, Color col, bool filled = false);
+	/**
+	 * @brief Lines joining each point to the next, in one draw call.
+	 *
+	 * Thick lines are drawn as one quad per segment, all in one geometry
+	 * call.
+	 */
+	void polyline(Span<const Vec2> points);
+	void polyline(Span<const Vec2> points, Color col);
 	void point(int x, int y);
 	void point(int x, int y, Color col);
+
+	/**
+	 * @brief A point with its own colour, for `points`.
+	 */
+	struct Point {
+		Vec2 position;
+		Color color;
+	};
+
+	/**
+	 * @brief Many points of one colour, in one draw call.
+	 */
+	void points(Span<const Vec2> points);
+	void points(Span<const Vec2> points, Color col);
+	/**
+	 * @brief Many points, each of its own colour.
+	 *
+	 * While there are only a few colours, the points are drawn in one call
+	 * per colour, so a point may be drawn before others of other colours
+	 * listed ahead of it. With many colours, they are all drawn as geometry
+	 * in a single call instead.
+	 */
+	void points(Span<const Point> points);
 	void line(int x1, int y1, int x2, int y2);
 	void line(int x1, int y1, int x2, int y2, Color col);
-	void line(const std::vector<int> lines);
-	void line(const std::vector<int> lines, Color col);
+	void line(const std::vector<int> &lines);
+	void line(const std::vector<int> &lines, Color col);
 	void arc(int x, int y, int r, int a1, int a2, bool filled = false);
 	void arc(int x, int y, int r, int a1, int a2, Color col, bool filled = false);
 	void arcFilled(int x, int y, int r, int a1, int a2);
 	void arcFilled(int x, int y, int r, int a1, int a2, Color col);
 	void clear();
 	void clear(Color col);
-	void print(std::string str, int x = 0, int y = 0);
-	void print(std::string str, int x, int y, Font font);
-	void print(std::string str, int x, int y, Color col);
-	void print(std::string str, int x, int y, Font font, Color col);
+	void print(const char *str, int x = 0, int y = 0);
+	void print(const char *str, int x, int y, Font font);
+	void print(const char *str, int x, int y, Color col);
+	void print(const char *str, int x, int y, Font font, Color col);
+	void print(const std::string &str, int x = 0, int y = 0);
+	void print(const std::string &str, int x, int y, Font font);
+	void print(const std::string &str, int x, int y, Color col);
+	void print(const std::string &str, int x, int y, Font font, Color col);
 	Font getFont();
 	void setFont(Font newFont);
 	void render(Image image, int x, int y);
+	/**
+	 * @brief Draw an image placed by `params`, ignoring its own transforms.
+	 *
+	 * The image's texture is uploaded on its first draw and kept, so one
+	 * image can be drawn many times a frame in different places at the cost
+	 * of a geometry call each.
+	 */
+	void draw(Image image, const DrawParams &params);
+	void draw(Image image, float x = 0.0f, float y = 0.0f);
 	std::tuple<int, int> getVirtualCoords(int x, int y);
 	Image screenshot();
 
+	/**
+	 * @brief Save the current transform, to be restored by `pop`.
+	 *
+	 * Every draw goes through the current transform, a single matrix
+	 * updated by `translate`, `scale`, `rotate` and `shear`, each applied
+	 * before those already made. Draws whose transformed bounds land
+	 * outside the screen, or the scissor rect, are skipped before reaching
+	 * SDL. The transform is reset at the start of every frame.
+	 */
+	void push();
+	void pop();
+	/**
+	 * @brief Reset the current transform to the identity.
+	 */
+	void origin();
+	void translate(float dx, float dy);
+	void scale(float sx, float sy);
+	/**
+	 * @brief Rotate by `radians`, clockwise on screen.
+	 */
+	void rotate(float radians);
+	void shear(float kx, float ky);
+	void applyTransform(const Mat3 &transform);
+	Mat3 getTransform();
+	void setTransform(const Mat3 &transform);
+	/**
+	 * @brief Where a point lands on screen under the current transform.
+	 */
+	Vec2 transformPoint(Vec2 point);
+	/**
+	 * @brief The point that lands on `point` under the current transform,
+	 * e.g. what the mouse is over.
+	 */
+	Vec2 inverseTransformPoint(Vec2 point);
+	/**
+	 * @brief Only draw inside `rect`, in screen coordinates.
+	 */
+	void setScissor(const Rect &rect);
+	/**
+	 * @brief Draw anywhere on the screen again.
+	 */
+	void setScissor();
+	std::optional<Rect> getScissor();
+
+};
+
+/**
+ * @brief A view of a 2D world, centred on a point
+ *
+ * Between `attach` and `detach`, draws are in world coordinates, with
+ * `position` at the centre of the screen. Draws landing off screen are
+ * culled like any others.
+ */
+struct Camera {
+	Vec2 position;
+	float zoom = 1.0f;
+	// in radians; turning the camera clockwise turns the world the other way
+	float rotation = 0.0f;
+
+	/**
+	 * @brief The world to screen transform, for the current screen size.
+	 */
+	Mat3 getTransform() const;
+	/**
+	 * @brief Push the graphics transform, then apply the camera's.
+	 */
+	void attach() const;
+	void detach() const;
+	Vec2 toScreen(Vec2 world) const;
+	Vec2 toWorld(Vec2 screen) const;
 };
 
 } // namespace Astrum
@@ -52,6 +52,12 @@ public:
 	 */
 	std::shared_ptr<struct ImageData> getData();
 
+	/**
+	 * @brief The transforms used by `graphics::render`.
+	 *
+	 * These are shared by every copy of the image. To draw one image in
+	 * several places at once, use `graphics::draw` with `DrawParams`.
+	 */
 	const Transforms &getTransforms() const;
 	Transforms &getTransforms();
 	int getWidth() const;
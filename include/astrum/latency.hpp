@@ -0,0 +1,60 @@
+#ifndef INCLUDE_ASTRUM_LATENCY
+#define INCLUDE_ASTRUM_LATENCY
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+#include "constants.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Rolling input-to-present latency figures, in milliseconds.
+ *
+ * `buckets[i]` counts samples with a latency of `i` milliseconds; the last
+ * bucket also counts everything slower. Percentiles are bucket-accurate.
+ */
+struct LatencyStats {
+	static constexpr std::size_t BUCKET_COUNT = 100;
+
+	std::size_t samples = 0;
+	double min = 0.0;
+	double mean = 0.0;
+	double max = 0.0;
+	double p50 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+	std::array<std::uint32_t, BUCKET_COUNT> buckets = { };
+};
+
+/**
+ * @brief Measures the time from input to the frame showing it
+ *
+ * Every key, mouse button, mouse motion, wheel and gamepad event is stamped
+ * with the time SDL received it. When the first frame drawn after handling the
+ * event is presented, the difference is recorded. Only the last `WINDOW`
+ * samples are kept, so the figures follow changes to vsync, the frame limiter
+ * or `Config::presentAfterDraw` within a few seconds.
+ */
+namespace latency {
+
+	constexpr std::size_t WINDOW = 512;
+
+	LatencyStats getStats();
+	/**
+	 * @brief Forget every sample taken so far.
+	 */
+	void reset();
+	/**
+	 * @brief Draw the current figures and histogram.
+	 *
+	 * Meant to be called from a `draw` callback, as a debugging overlay.
+	 */
+	void drawOverlay(int x = 0, int y = 0);
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_LATENCY
@@ -1,8 +1,61 @@
 #ifndef INCLUDE_ASTRUM_LOG
 #define INCLUDE_ASTRUM_LOG
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "util.hpp"
+
+// values for ASTRUM_LOG_MIN_LEVEL, in the same order as `LogCategory`
+#define ASTRUM_LOG_LEVEL_DEBUG 0
+#define ASTRUM_LOG_LEVEL_INFO  1
+#define ASTRUM_LOG_LEVEL_WARN  2
+#define ASTRUM_LOG_LEVEL_ERROR 3
+#define ASTRUM_LOG_LEVEL_NONE  4
+
+// set by CMake; see the ASTRUM_LOG_MIN_LEVEL cache variable
+#ifndef ASTRUM_LOG_MIN_LEVEL
+#	define ASTRUM_LOG_MIN_LEVEL ASTRUM_LOG_LEVEL_DEBUG
+#endif
+
+// Levels at or above ASTRUM_LOG_MIN_LEVEL check the runtime priority before
+// evaluating their arguments. Levels below it compile to nothing; the call is
+// kept behind `if (false)` only so the format string is still checked and
+// variables used just for logging don't trigger unused warnings.
+#define ASTRUM_LOG_ENABLED_(cat, func, ...) \
+	do { \
+		if (::Astrum::log::LogCategory::cat \
+			>= ::Astrum::log::getLogPriority()) \
+			::Astrum::log::func(__VA_ARGS__); \
+	} while (0)
+#define ASTRUM_LOG_DISABLED_(func, ...) \
+	do { \
+		if (false) \
+			::Astrum::log::func(__VA_ARGS__); \
+	} while (0)
+
+#if ASTRUM_LOG_MIN_LEVEL <= ASTRUM_LOG_LEVEL_DEBUG
+#	define ASTRUM_LOG_DEBUG(...) ASTRUM_LOG_ENABLED_(debug, debug, __VA_ARGS__)
+#else
+#	define ASTRUM_LOG_DEBUG(...) ASTRUM_LOG_DISABLED_(debug, __VA_ARGS__)
+#endif
+#if ASTRUM_LOG_MIN_LEVEL <= ASTRUM_LOG_LEVEL_INFO
+#	define ASTRUM_LOG_INFO(...) ASTRUM_LOG_ENABLED_(info, info, __VA_ARGS__)
+#else
+#	define ASTRUM_LOG_INFO(...) ASTRUM_LOG_DISABLED_(info, __VA_ARGS__)
+#endif
+#if ASTRUM_LOG_MIN_LEVEL <= ASTRUM_LOG_LEVEL_WARN
+#	define ASTRUM_LOG_WARN(...) ASTRUM_LOG_ENABLED_(warn, warn, __VA_ARGS__)
+#else
+#	define ASTRUM_LOG_WARN(...) ASTRUM_LOG_DISABLED_(warn, __VA_ARGS__)
+#endif
+#if ASTRUM_LOG_MIN_LEVEL <= ASTRUM_LOG_LEVEL_ERROR
+#	define ASTRUM_LOG_ERROR(...) ASTRUM_LOG_ENABLED_(error, error, __VA_ARGS__)
+#else
+#	define ASTRUM_LOG_ERROR(...) ASTRUM_LOG_DISABLED_(error, __VA_ARGS__)
+#endif
+
 namespace Astrum {
 
 /**
@@ -10,6 +63,11 @@ namespace Astrum {
  *
  * Namespace for logging functions. Functions log to standard output or to a
  * file, as appropriate for the system and environment.
+ *
+ * For logging in hot code, prefer the `ASTRUM_LOG_DEBUG`, `ASTRUM_LOG_INFO`,
+ * `ASTRUM_LOG_WARN` and `ASTRUM_LOG_ERROR` macros: they skip evaluating their
+ * arguments when the priority filters the message out, and compile to nothing
+ * below the build's `ASTRUM_LOG_MIN_LEVEL`.
  */
 namespace log {
 
@@ -21,6 +79,54 @@ namespace log {
 	 */
 	enum class LogCategory { debug, info, warn, error };
 
+	/**
+	 * @brief What to do when the asynchronous queue is full
+	 *
+	 * `drop` discards the new message and counts it (see `getDroppedCount`);
+	 * `block` makes the logging thread wait until the writer frees a slot.
+	 */
+	enum class OverflowPolicy { drop, block };
+
+	/**
+	 * @brief Number of messages the asynchronous queue can hold.
+	 */
+	constexpr std::size_t ASYNC_QUEUE_SIZE = 1024;
+	/**
+	 * @brief Longest message the asynchronous queue holds, in bytes.
+	 *
+	 * Longer messages are truncated.
+	 */
+	constexpr std::size_t ASYNC_MESSAGE_SIZE = 256;
+
+	/**
+	 * @brief Settings for the log file
+	 *
+	 * See `openFile`.
+	 */
+	struct LogFileOptions {
+		// start a new file once the current one would grow past this
+		std::size_t maxFileSize = 4 * 1024 * 1024;
+		// files kept, including the current one
+		int maxFiles = 5;
+		// bytes collected before writing to the file
+		std::size_t bufferSize = 64 * 1024;
+		// write compact binary records, read with the `astrumLogDecode` tool
+		bool binary = false;
+		// keep logging to the console as well
+		bool echo = false;
+	};
+
+	/**
+	 * @brief The first bytes of a binary log file.
+	 *
+	 * The magic is followed by the time the file was opened, as a 64-bit
+	 * little-endian count of seconds since the Unix epoch. Every record is a
+	 * one-byte `LogCategory`, the milliseconds since startup as a 32-bit
+	 * integer, the message length as a 16-bit integer (all little-endian) and
+	 * the message itself, without a terminator.
+	 */
+	constexpr char LOG_FILE_MAGIC[9] = "ASTRLOG1";
+
 	/**
 	 * @brief Get the current logging priority.
 	 *
@@ -41,6 +147,55 @@ namespace log {
 	 * @param priority The new priority for ignoring messages.
 	 */
 	void setLogPriority(LogCategory priority);
+	/**
+	 * @brief Move writing log messages to a background thread
+	 *
+	 * Once started, logging formats the message straight into a slot of a
+	 * lock-free queue and returns; a writer thread passes queued messages on
+	 * to the output. Any thread may log. The queue is flushed and the writer
+	 * stopped by `stopAsync`, which `Astrum::exit` calls. Does nothing if
+	 * asynchronous logging is already running, or on platforms without
+	 * threads.
+	 *
+	 * @param policy What to do with messages logged while the queue is full.
+	 */
+	void startAsync(OverflowPolicy policy = OverflowPolicy::drop);
+	/**
+	 * @brief Write out every queued message and go back to logging directly.
+	 */
+	void stopAsync();
+	bool isAsync();
+	/**
+	 * @brief Wait until every message logged so far has been written.
+	 *
+	 * Also writes out the log file buffer, if a log file is open.
+	 */
+	void flush();
+	/**
+	 * @brief The number of messages dropped because the queue was full.
+	 */
+	std::uint64_t getDroppedCount();
+	/**
+	 * @brief Start writing the log to files in the app directory
+	 *
+	 * Messages are written to `logs/astrum.log` (or `astrum.alog` for the
+	 * binary format) in `filesystem::getAppDirectory()`, collected in a buffer
+	 * and written out in large blocks. The buffer is also written out right
+	 * away for `error` messages, and by `flush`. When the file would grow past
+	 * `maxFileSize`, it is renamed to `astrum.1.log`, older files move up by
+	 * one, and the oldest beyond `maxFiles` is deleted; the same happens to a
+	 * file left over from the previous run. Unless `echo` is set, messages no
+	 * longer go to the console. Call after `Astrum::init`; closed by
+	 * `Astrum::exit`.
+	 *
+	 * @return Whether the file could be opened.
+	 */
+	bool openFile(const LogFileOptions &options = LogFileOptions());
+	/**
+	 * @brief Write out the buffer and go back to logging to the console.
+	 */
+	void closeFile();
+	bool isFileOpen();
 	/**
 	 * @brief Logs with `va_list` instead of variadic arguments
 	 *
@@ -51,14 +206,15 @@ namespace log {
 	 * @param format The message to be formatted and logged
 	 * @param args Format parameters
 	 */
-	void vlog(LogCategory cat, std::string format, va_list args);
+	void vlog(LogCategory cat, const char *format, va_list args)
+		ASTRUM_PRINTF(2, 0);
 	/**
 	 * @brief Defaults to `info` priority
 	 *
 	 * Logs with the `LogCategory::info` category by default.
 	 * @overload
 	 */
-	void vlog(std::string format, va_list args);
+	void vlog(const char *format, va_list args) ASTRUM_PRINTF(1, 0);
 	/**
 	 * @brief Logs the message with the given priority
 	 *
@@ -69,38 +225,38 @@ namespace log {
 	 * @param format The message to be formatted and logged
 	 * @param ... Format parameters
 	 */
-	void log(LogCategory cat, std::string format, ...);
+	void log(LogCategory cat, const char *format, ...) ASTRUM_PRINTF(2, 3);
 	/**
 	 * @brief Defaults to `info` priority
 	 *
 	 * Logs with the `LogCategory::info` category by default.
 	 * @overload
 	 */
-	void log(std::string format, ...);
+	void log(const char *format, ...) ASTRUM_PRINTF(1, 2);
 	/**
 	 * @brief Shorthand for logging with `info`
 	 *
 	 * Equivalent to `log(LogCategory::info, format, ...)`.
 	 */
-	void info(std::string format, ...);
+	void info(const char *format, ...) ASTRUM_PRINTF(1, 2);
 	/**
 	 * @brief Shorthand for logging with `debug`
 	 *
 	 * Equivalent to `log(LogCategory::debug, format, ...)`.
 	 */
-	void debug(std::string format, ...);
+	void debug(const char *format, ...) ASTRUM_PRINTF(1, 2);
 	/**
 	 * @brief Shorthand for logging with `warn`
 	 *
 	 * Equivalent to `log(LogCategory::warn, format, ...)`.
 	 */
-	void warn(std::string format, ...);
+	void warn(const char *format, ...) ASTRUM_PRINTF(1, 2);
 	/**
 	 * @brief Shorthand for logging with `error`
 	 *
 	 * Equivalent to `log(LogCategory::error, format, ...)`.
 	 */
-	void error(std::string format, ...);
+	void error(const char *format, ...) ASTRUM_PRINTF(1, 2);
 
 }
 
@@ -1,23 +1,390 @@
 #ifndef INCLUDE_ASTRUM_MATH
 #define INCLUDE_ASTRUM_MATH
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <utility>
 #include <type_traits>
 #include <cmath>
 #include <random>
 
 #include "constants.hpp"
+#include "util.hpp"
 
 namespace Astrum {
 
+struct Vec2 {
+	float x = 0.0f;
+	float y = 0.0f;
+
+	constexpr Vec2() = default;
+	constexpr Vec2(float x, float y) : x(x), y(y) { }
+
+	constexpr Vec2 operator+(Vec2 other) const {
+		return Vec2(this->x + other.x, this->y + other.y);
+	}
+	constexpr Vec2 operator-(Vec2 other) const {
+		return Vec2(this->x - other.x, this->y - other.y);
+	}
+	constexpr Vec2 operator-() const {
+		return Vec2(-this->x, -this->y);
+	}
+	constexpr Vec2 operator*(float scale) const {
+		return Vec2(this->x * scale, this->y * scale);
+	}
+	constexpr Vec2 operator/(float scale) const {
+		return Vec2(this->x / scale, this->y / scale);
+	}
+	constexpr Vec2 &operator+=(Vec2 other) {
+		this->x += other.x;
+		this->y += other.y;
+		return *this;
+	}
+	constexpr Vec2 &operator-=(Vec2 other) {
+		this->x -= other.x;
+		this->y -= other.y;
+		return *this;
+	}
+	constexpr Vec2 &operator*=(float scale) {
+		this->x *= scale;
+		this->y *= scale;
+		return *this;
+	}
+	constexpr bool operator==(Vec2 other) const {
+		return this->x == other.x && this->y == other.y;
+	}
+	constexpr bool operator!=(Vec2 other) const {
+		return !(*this == other);
+	}
+
+	constexpr float dot(Vec2 other) const {
+		return this->x * other.x + this->y * other.y;
+	}
+	/**
+	 * @brief The z of the 3D cross product; positive when `other` is
+	 * counter-clockwise from this.
+	 */
+	constexpr float cross(Vec2 other) const {
+		return this->x * other.y - this->y * other.x;
+	}
+	constexpr float lengthSquared() const {
+		return this->dot(*this);
+	}
+	float length() const {
+		return std::sqrt(this->lengthSquared());
+	}
+	/**
+	 * @brief The same direction with a length of 1, or zero for zero.
+	 */
+	Vec2 normalized() const {
+		float len = this->length();
+		return len == 0.0f ? Vec2() : *this / len;
+	}
+};
+
+constexpr Vec2 operator*(float scale, Vec2 vec) {
+	return vec * scale;
+}
+
+/**
+ * @brief An axis-aligned rectangle, from its top-left corner.
+ */
+struct Rect {
+	float x = 0.0f;
+	float y = 0.0f;
+	float w = 0.0f;
+	float h = 0.0f;
+
+	constexpr Rect() = default;
+	constexpr Rect(float x, float y, float w, float h)
+		: x(x), y(y), w(w), h(h) { }
+
+	constexpr float left() const {
+		return this->x;
+	}
+	constexpr float top() const {
+		return this->y;
+	}
+	constexpr float right() const {
+		return this->x + this->w;
+	}
+	constexpr float bottom() const {
+		return this->y + this->h;
+	}
+	constexpr Vec2 center() const {
+		return Vec2(this->x + this->w / 2, this->y + this->h / 2);
+	}
+
+	/**
+	 * @brief Whether a point is inside; the right and bottom edges are not.
+	 */
+	constexpr bool contains(Vec2 point) const {
+		return point.x >= this->x && point.x < this->right()
+			&& point.y >= this->y && point.y < this->bottom();
+	}
+	constexpr bool intersects(const Rect &other) const {
+		return this->x < other.right() && other.x < this->right()
+			&& this->y < other.bottom() && other.y < this->bottom();
+	}
+	constexpr bool operator==(const Rect &other) const {
+		return this->x == other.x && this->y == other.y
+			&& this->w == other.w && this->h == other.h;
+	}
+	constexpr bool operator!=(const Rect &other) const {
+		return !(*this == other);
+	}
+};
+
+/**
+ * @brief A 2D affine transform, the 3x3 matrix
+ *
+ *     | a  c  tx |
+ *     | b  d  ty |
+ *     | 0  0  1  |
+ *
+ * of which only the top two rows are stored. `m1 * m2` applies `m2` first.
+ */
+struct Mat3 {
+	float a = 1.0f;
+	float b = 0.0f;
+	float c = 0.0f;
+	float d = 1.0f;
+	float tx = 0.0f;
+	float ty = 0.0f;
+
+	constexpr Mat3() = default;
+	constexpr Mat3(float a, float b, float c, float d, float tx, float ty)
+		: a(a), b(b), c(c), d(d), tx(tx), ty(ty) { }
+
+	static constexpr Mat3 identity() {
+		return Mat3();
+	}
+	static constexpr Mat3 translation(float dx, float dy) {
+		return Mat3(1.0f, 0.0f, 0.0f, 1.0f, dx, dy);
+	}
+	static constexpr Mat3 scaling(float sx, float sy) {
+		return Mat3(sx, 0.0f, 0.0f, sy, 0.0f, 0.0f);
+	}
+	static constexpr Mat3 shearing(float kx, float ky) {
+		return Mat3(1.0f, ky, kx, 1.0f, 0.0f, 0.0f);
+	}
+	/**
+	 * @brief Rotation by `radians`, clockwise on screen since y points down.
+	 */
+	static Mat3 rotation(float radians) {
+		float cos = std::cos(radians);
+		float sin = std::sin(radians);
+		return Mat3(cos, sin, -sin, cos, 0.0f, 0.0f);
+	}
+
+	constexpr Mat3 operator*(const Mat3 &other) const {
+		return Mat3(
+			this->a * other.a + this->c * other.b,
+			this->b * other.a + this->d * other.b,
+			this->a * other.c + this->c * other.d,
+			this->b * other.c + this->d * other.d,
+			this->a * other.tx + this->c * other.ty + this->tx,
+			this->b * other.tx + this->d * other.ty + this->ty);
+	}
+	constexpr Mat3 &operator*=(const Mat3 &other) {
+		return *this = *this * other;
+	}
+	constexpr bool operator==(const Mat3 &other) const {
+		return this->a == other.a && this->b == other.b
+			&& this->c == other.c && this->d == other.d
+			&& this->tx == other.tx && this->ty == other.ty;
+	}
+	constexpr bool operator!=(const Mat3 &other) const {
+		return !(*this == other);
+	}
+
+	constexpr Vec2 apply(Vec2 point) const {
+		return Vec2(this->a * point.x + this->c * point.y + this->tx,
+			this->b * point.x + this->d * point.y + this->ty);
+	}
+	/**
+	 * @brief Transform a direction, which ignores the translation.
+	 */
+	constexpr Vec2 applyVector(Vec2 vec) const {
+		return Vec2(this->a * vec.x + this->c * vec.y,
+			this->b * vec.x + this->d * vec.y);
+	}
+	/**
+	 * @brief The axis-aligned bounds of a transformed rectangle.
+	 */
+	constexpr Rect applyRect(const Rect &rect) const {
+		Vec2 center = this->apply(rect.center());
+		float hw = rect.w / 2;
+		float hh = rect.h / 2;
+		float ex = absf(this->a) * hw + absf(this->c) * hh;
+		float ey = absf(this->b) * hw + absf(this->d) * hh;
+		return Rect(center.x - ex, center.y - ey, ex * 2, ey * 2);
+	}
+
+	constexpr float determinant() const {
+		return this->a * this->d - this->b * this->c;
+	}
+	/**
+	 * @brief The transform that undoes this one.
+	 *
+	 * Only valid when the determinant isn't 0, i.e. nothing was scaled to
+	 * nothing.
+	 */
+	constexpr Mat3 inverse() const {
+		float inv = 1.0f / this->determinant();
+		return Mat3(this->d * inv, -this->b * inv, -this->c * inv,
+			this->a * inv,
+			(this->c * this->ty - this->d * this->tx) * inv,
+			(this->b * this->tx - this->a * this->ty) * inv);
+	}
+
+private:
+	// std::abs isn't constexpr until C++23
+	static constexpr float absf(float val) {
+		return val < 0.0f ? -val : val;
+	}
+};
+
 namespace math {
 
+	/**
+	 * @brief A xoshiro256** pseudo-random generator
+	 *
+	 * Small and fast, but not suitable for cryptographic purposes. Each
+	 * seed has 2^64 streams, starting at unrelated points of a 2^256 - 1
+	 * period so they never overlap in practice, and threads can draw
+	 * reproducible, independent numbers from one seed. Usable with the
+	 * standard library as a UniformRandomBitGenerator, e.g. `std::shuffle`.
+	 */
+	class RandomGenerator {
+	private:
+		std::uint64_t s[4];
+
+		static constexpr std::uint64_t rotl(std::uint64_t x, int k) {
+			return (x << k) | (x >> (64 - k));
+		}
+
+	public:
+		using result_type = std::uint64_t;
+
+		/**
+		 * @brief Seed the state through splitmix64, mixed with `stream`.
+		 *
+		 * Any stream takes the same constant time to set up.
+		 */
+		explicit RandomGenerator(std::uint64_t seed = 0, std::uint64_t stream = 0);
+
+		static constexpr result_type min() {
+			return 0;
+		}
+		static constexpr result_type max() {
+			return std::numeric_limits<result_type>::max();
+		}
+
+		result_type operator()() {
+			const std::uint64_t result = rotl(this->s[1] * 5, 7) * 9;
+			const std::uint64_t t = this->s[1] << 17;
+			this->s[2] ^= this->s[0];
+			this->s[3] ^= this->s[1];
+			this->s[1] ^= this->s[2];
+			this->s[0] ^= this->s[3];
+			this->s[2] ^= t;
+			this->s[3] = rotl(this->s[3], 45);
+			return result;
+		}
+
+		std::uint32_t next32() {
+			// the high bits are the strongest
+			return static_cast<std::uint32_t>((*this)() >> 32);
+		}
+
+		/**
+		 * @brief A uniform integer in [0, range), without modulo bias.
+		 *
+		 * Uses Lemire's multiply-and-reject method, which almost never
+		 * needs a second draw. A range of 0 returns any 32-bit value.
+		 */
+		std::uint32_t bounded(std::uint32_t range) {
+			if (range == 0)
+				return this->next32();
+			std::uint64_t m = static_cast<std::uint64_t>(this->next32()) * range;
+			std::uint32_t low = static_cast<std::uint32_t>(m);
+			if (low < range) {
+				std::uint32_t threshold = -range % range;
+				while (low < threshold) {
+					m = static_cast<std::uint64_t>(this->next32()) * range;
+					low = static_cast<std::uint32_t>(m);
+				}
+			}
+			return static_cast<std::uint32_t>(m >> 32);
+		}
+
+		/**
+		 * @brief A uniform double in [0, 1).
+		 */
+		double nextDouble() {
+			return ((*this)() >> 11) * 0x1.0p-53;
+		}
+		/**
+		 * @brief A uniform float in [0, 1).
+		 */
+		float nextFloat() {
+			return ((*this)() >> 40) * 0x1.0p-24f;
+		}
+
+		/**
+		 * @brief Advance 2^128 draws, for a sequence that can't overlap this
+		 * one within that many draws.
+		 */
+		void jump();
+	};
+
+	/*
+	 * Each thread draws from its own generator, so these are safe to call
+	 * from any thread. The thread that calls `randomseed` (or `Astrum::init`)
+	 * gets stream 0 of the seed, and other threads get the following streams
+	 * in the order they first draw a number, unless they pick one with
+	 * `randomstream`.
+	 */
 	unsigned random();
+	/**
+	 * @brief A uniform integer in [0, max].
+	 */
 	unsigned random(unsigned max);
+	/**
+	 * @brief A uniform integer in [min, max].
+	 */
 	unsigned random(unsigned min, unsigned max);
+	/**
+	 * @brief A uniform double in [0, max).
+	 */
 	double randfloat(double max = 1.0);
 	double randfloat(double min, double max);
 	void randomseed(unsigned s);
+	/**
+	 * @brief Switch the calling thread to a stream of the current seed.
+	 *
+	 * Worker threads that each pick a fixed stream get the same numbers
+	 * every run, whatever order they happen to start in.
+	 */
+	void randomstream(std::uint64_t stream);
+	/**
+	 * @brief The calling thread's generator, for standard algorithms.
+	 */
+	RandomGenerator &getRandomGenerator();
+
+	/**
+	 * @brief Fill `out` with uniform integers in [min, max].
+	 *
+	 * Much faster than calling `random` in a loop.
+	 */
+	void fillrandom(Span<unsigned> out, unsigned min, unsigned max);
+	/**
+	 * @brief Fill `out` with uniform floats in [min, max).
+	 */
+	void fillrandfloat(Span<float> out, float min = 0.0f, float max = 1.0f);
+	void fillrandfloat(Span<double> out, double min = 0.0, double max = 1.0);
 
 	template <typename T1>
 	T1 min(T1 a) {
@@ -52,6 +419,17 @@ namespace math {
 	inline double log(double val);
 	inline double log(double base, double val);
 
+	/*
+	 * Batched transforms, several points or rects at a time with SSE or AVX
+	 * where the build targets it, and one at a time otherwise. `in` and `out`
+	 * must be the same size, and may be the same span.
+	 */
+	void transformPoints(const Mat3 &mat, Span<const Vec2> in, Span<Vec2> out);
+	/**
+	 * @brief Transform each rect into the axis-aligned bounds of the result.
+	 */
+	void transformRects(const Mat3 &mat, Span<const Rect> in, Span<Rect> out);
+
 };
 
 }; // namespace Astrum
@@ -0,0 +1,100 @@
+#ifndef INCLUDE_ASTRUM_MESH
+#define INCLUDE_ASTRUM_MESH
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "constants.hpp"
+#include "graphics.hpp"
+#include "image.hpp"
+#include "math.hpp"
+#include "util.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Triangles built once and drawn many times
+ *
+ * A mesh keeps its vertices in the form the renderer takes them, so a draw
+ * only transforms their positions before handing the whole mesh over in one
+ * geometry call. Shapes like circles are tessellated when the mesh is made,
+ * instead of on every draw like `graphics::circle`.
+ *
+ * The shape helpers centre shapes on `0, 0` and can add an anti-aliasing
+ * fringe: a strip along each curved edge that fades from opaque to clear.
+ * The fringe is in the mesh's own units, so it is scaled along with the
+ * mesh when drawn.
+ *
+ * Copies share the same vertices, like copies of an `Image`.
+ */
+class Mesh {
+private:
+	std::shared_ptr<struct MeshData> data;
+
+public:
+	struct Vertex {
+		Vec2 position;
+		// texture coordinates, 0 to 1 across the image
+		Vec2 uv;
+		Color color = Color(0xFF, 0xFF, 0xFF, 0xFF);
+	};
+
+	Mesh();
+	/**
+	 * @brief A mesh of triangles, three indices each, or of every three
+	 * vertices when `indices` is empty.
+	 */
+	Mesh(Span<const Vertex> vertices, Span<const int> indices = Span<const int>());
+
+	static Mesh ellipse(float rx, float ry, int segments = 32,
+		float fringe = 1.0f);
+	static Mesh circle(float radius, int segments = 32, float fringe = 1.0f);
+	/**
+	 * @brief A filled slice of a circle, from `from` to `to` radians
+	 * clockwise. Only the curved edge has a fringe.
+	 */
+	static Mesh pie(float radius, float from, float to, int segments = 32,
+		float fringe = 1.0f);
+	/**
+	 * @brief The outline of an ellipse, `thickness` wide.
+	 */
+	static Mesh ring(float rx, float ry, float thickness, int segments = 32,
+		float fringe = 1.0f);
+	/**
+	 * @brief Part of the outline of a circle, from `from` to `to` radians
+	 * clockwise.
+	 */
+	static Mesh arc(float radius, float from, float to, float thickness,
+		int segments = 32, float fringe = 1.0f);
+
+	/**
+	 * @brief Draw through `params` and the graphics transform, tinted by
+	 * `params.tint`.
+	 *
+	 * Flips mirror the mesh about its own `0, 0`; `params.source` is
+	 * ignored.
+	 */
+	void draw(const graphics::DrawParams &params) const;
+	void draw(float x = 0.0f, float y = 0.0f) const;
+
+	std::size_t getVertexCount() const;
+	Vertex getVertex(std::size_t index) const;
+	void setVertex(std::size_t index, const Vertex &vertex);
+	void setVertices(Span<const Vertex> vertices);
+	void setIndices(Span<const int> indices);
+	/**
+	 * @brief The image mapped onto the mesh by the vertices' `uv`.
+	 *
+	 * The shape helpers stretch the image across the shape's bounds.
+	 */
+	void setImage(std::optional<Image> image);
+	/**
+	 * @brief The bounds of the vertices, before any transform.
+	 */
+	Rect getBounds() const;
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_MESH
@@ -1,6 +1,7 @@
 #ifndef INCLUDE_ASTRUM_MOUSE
 #define INCLUDE_ASTRUM_MOUSE
 
+#include <cstdint>
 #include <tuple>
 #include <optional>
 #include <memory>
@@ -14,6 +15,21 @@ enum class MouseButton {
 	LEFT, MIDDLE, RIGHT, X1, X2
 };
 
+/**
+ * @brief One mouse motion sample, as delivered in raw motion mode.
+ *
+ * `x` and `y` are the position after the motion, `dx` and `dy` the distance
+ * moved since the previous sample, and `timestamp` the time SDL received the
+ * sample, in milliseconds since startup.
+ */
+struct MouseMotion {
+	int x;
+	int y;
+	int dx;
+	int dy;
+	std::uint32_t timestamp;
+};
+
 class Cursor {
 private:
 	std::shared_ptr<struct CursorData> data;
@@ -40,6 +56,19 @@ namespace mouse {
 	std::optional<Cursor> getCursor();
 	void setCursor(Cursor cursor);
 
+	/**
+	 * @brief Whether raw motion samples are being collected.
+	 *
+	 * Mouse motion is coalesced: `mousemoved` is called at most once between
+	 * other mouse events, with the latest position and the summed distance.
+	 * In raw mode, every sample is also kept and handed to the
+	 * `mousemotionraw` listeners in batches: once per frame, and also before
+	 * each button or wheel event, so a batch never spans one. Off by
+	 * default.
+	 */
+	bool hasRawMotion();
+	void setRawMotion(bool state);
+
 	extern std::optional<Cursor> CURSOR_ARROW;
 	extern std::optional<Cursor> CURSOR_IBEAM;
 	extern std::optional<Cursor> CURSOR_WAIT;
@@ -0,0 +1,116 @@
+#ifndef INCLUDE_ASTRUM_PARTICLES
+#define INCLUDE_ASTRUM_PARTICLES
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "constants.hpp"
+#include "image.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Many short-lived sprites, updated and drawn together
+ *
+ * Particles live in a pool of fixed capacity, stored as one array per
+ * attribute so updates run several particles at a time with SIMD. Each
+ * particle moves in a straight line under a shared acceleration and damping,
+ * and fades from one size and colour to another over its lifetime. The whole
+ * system is drawn with a single geometry call, textured with an `Image` or as
+ * flat shapes.
+ *
+ * Copies share the same particles, like copies of an `Image`.
+ */
+class ParticleSystem {
+private:
+	std::shared_ptr<struct ParticleData> data;
+
+public:
+	enum class Shape { square, triangle };
+
+	explicit ParticleSystem(std::size_t capacity);
+	ParticleSystem(Image image, std::size_t capacity);
+
+	/**
+	 * @brief Age, move and emit particles.
+	 */
+	void update(double dt);
+	/**
+	 * @brief Draw every particle, offset by `x, y`.
+	 *
+	 * Goes through the graphics transform; particles landing off the view
+	 * are left out.
+	 */
+	void draw(float x = 0.0f, float y = 0.0f) const;
+
+	/**
+	 * @brief Emit `count` particles at once, on top of the rate.
+	 *
+	 * Particles beyond the capacity are not emitted.
+	 */
+	void emit(std::size_t count);
+	/**
+	 * @brief Start emitting at the emission rate; systems start active.
+	 */
+	void start();
+	void stop();
+	bool isActive() const;
+	/**
+	 * @brief Remove every particle.
+	 */
+	void reset();
+
+	std::size_t getCount() const;
+	std::size_t getCapacity() const;
+
+	/**
+	 * @brief Particles emitted per second while active.
+	 */
+	void setEmissionRate(float perSecond);
+	void setPosition(float x, float y);
+	/**
+	 * @brief Emit anywhere in a rect of this size, centred on the position.
+	 */
+	void setAreaSpread(float width, float height);
+	/**
+	 * @brief The direction particles leave in, in radians.
+	 */
+	void setDirection(float radians);
+	/**
+	 * @brief The angle around the direction that particles leave in,
+	 * in radians; 2 pi emits in all directions.
+	 */
+	void setSpread(float radians);
+	void setSpeed(float min, float max);
+	void setParticleLifetime(float min, float max);
+	void setLinearAcceleration(float x, float y);
+	/**
+	 * @brief How quickly particles slow down, as a fraction of their speed
+	 * lost per second.
+	 */
+	void setLinearDamping(float damping);
+	/**
+	 * @brief The size, in pixels, at the start and end of each lifetime.
+	 */
+	void setSizes(float start, float end);
+	void setColors(Color start, Color end);
+	/**
+	 * @brief The shape drawn for each particle.
+	 *
+	 * Images are drawn over the shape, so squares suit most images.
+	 */
+	void setShape(Shape shape);
+	void setImage(std::optional<Image> image);
+	/**
+	 * @brief Split updates of large systems across threads.
+	 *
+	 * Threads are started on each update, so this only pays off with tens
+	 * of thousands of particles. Ignored on Emscripten.
+	 */
+	void setParallel(bool parallel);
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_PARTICLES
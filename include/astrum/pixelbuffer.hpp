@@ -0,0 +1,93 @@
+#ifndef INCLUDE_ASTRUM_PIXELBUFFER
+#define INCLUDE_ASTRUM_PIXELBUFFER
+
+#include <cstdint>
+#include <memory>
+
+#include "constants.hpp"
+#include "graphics.hpp"
+#include "util.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Pixels written by the CPU and drawn like an image
+ *
+ * The pixels live in memory, with a streaming texture on the renderer's
+ * side. Between `lock` and `unlock` they can be written freely; `unlock`
+ * then uploads only the rows that were locked, in one call. Drawing is
+ * one textured quad, scaled with nearest-neighbour sampling so each pixel
+ * stays a sharp square.
+ *
+ * Copies share the same pixels, like copies of an `Image`.
+ */
+class PixelBuffer {
+private:
+	std::shared_ptr<struct PixelBufferData> data;
+
+public:
+	/**
+	 * @brief One pixel, stored as these four bytes in this order.
+	 */
+	struct Pixel {
+		std::uint8_t r = 0;
+		std::uint8_t g = 0;
+		std::uint8_t b = 0;
+		std::uint8_t a = 0xFF;
+
+		Pixel() = default;
+		constexpr Pixel(std::uint8_t r, std::uint8_t g, std::uint8_t b,
+			std::uint8_t a = 0xFF) : r(r), g(g), b(b), a(a) { }
+		Pixel(Color col) : r(col.r), g(col.g), b(col.b), a(col.a) { }
+	};
+
+	/**
+	 * @brief A buffer of opaque black pixels.
+	 */
+	PixelBuffer(int width, int height);
+
+	/**
+	 * @brief Every pixel, row by row, to write until `unlock`.
+	 */
+	Span<Pixel> lock();
+	/**
+	 * @brief Only `rows` rows from `firstRow`, so `unlock` uploads less.
+	 *
+	 * The span starts at the first of those rows. The range is clamped to
+	 * the buffer.
+	 */
+	Span<Pixel> lock(int firstRow, int rows);
+	/**
+	 * @brief Upload every row locked since the last upload.
+	 */
+	void unlock();
+	bool isLocked() const;
+
+	/**
+	 * @brief Read a pixel; pixels outside the buffer are transparent.
+	 */
+	Pixel getPixel(int x, int y) const;
+	/**
+	 * @brief Write one pixel, uploaded with the next `unlock`.
+	 *
+	 * Pixels outside the buffer are ignored.
+	 */
+	void setPixel(int x, int y, Pixel pixel);
+	/**
+	 * @brief Set every pixel, uploaded with the next `unlock`.
+	 */
+	void fill(Pixel pixel);
+
+	/**
+	 * @brief Draw what was last uploaded.
+	 */
+	void draw(const graphics::DrawParams &params) const;
+	void draw(float x = 0.0f, float y = 0.0f) const;
+
+	int getWidth() const;
+	int getHeight() const;
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_PIXELBUFFER
@@ -0,0 +1,63 @@
+#ifndef INCLUDE_ASTRUM_POLYGON
+#define INCLUDE_ASTRUM_POLYGON
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "constants.hpp"
+#include "graphics.hpp"
+#include "math.hpp"
+#include "util.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief A filled outline, triangulated once and drawn many times
+ *
+ * The outline may be concave, in either winding, but must not cross
+ * itself. It is split into triangles by ear clipping when the points are
+ * set, and every draw reuses those triangles through a `Mesh`.
+ *
+ * Copies share the same outline, like copies of an `Image`.
+ */
+class Polygon {
+private:
+	std::shared_ptr<struct PolygonData> data;
+
+public:
+	Polygon();
+	explicit Polygon(Span<const Vec2> points, Color color = Color(0xFF, 0xFF,
+		0xFF, 0xFF));
+
+	/**
+	 * @brief Split an outline into triangles, three indices each, appended
+	 * to `out`.
+	 *
+	 * Returns false if it runs out of ears, which outlines that cross
+	 * themselves can do, leaving whatever triangles were found before.
+	 */
+	static bool triangulate(Span<const Vec2> points, std::vector<int> &out);
+
+	/**
+	 * @brief Replace the outline and triangulate it again.
+	 *
+	 * Returns false if triangulation stopped early, in which case only
+	 * part of it will be filled.
+	 */
+	bool setPoints(Span<const Vec2> points);
+	const std::vector<Vec2> &getPoints() const;
+	/**
+	 * @brief The triangles, as indices into the points.
+	 */
+	const std::vector<int> &getTriangles() const;
+	Color getColor() const;
+	void setColor(Color color);
+
+	void draw(const graphics::DrawParams &params) const;
+	void draw(float x = 0.0f, float y = 0.0f) const;
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_POLYGON
@@ -0,0 +1,101 @@
+#ifndef INCLUDE_ASTRUM_PROFILE
+#define INCLUDE_ASTRUM_PROFILE
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "constants.hpp"
+
+// Scopes are only recorded when the library is built with the ASTRUM_PROFILE
+// CMake option; otherwise the macros expand to nothing.
+#ifdef ASTRUM_PROFILE
+#	define ASTRUM_PROFILE_CONCAT_(a, b) a##b
+#	define ASTRUM_PROFILE_VAR_(line) ASTRUM_PROFILE_CONCAT_(astrumProfileScope, line)
+#	define ASTRUM_PROFILE_SCOPE(name) \
+		::Astrum::profile::Scope ASTRUM_PROFILE_VAR_(__LINE__)(name)
+#	define ASTRUM_PROFILE_FUNCTION() ASTRUM_PROFILE_SCOPE(__func__)
+#else
+#	define ASTRUM_PROFILE_SCOPE(name) ((void) 0)
+#	define ASTRUM_PROFILE_FUNCTION() ((void) 0)
+#endif
+
+namespace Astrum {
+
+/**
+ * @brief Records timed scopes for viewing in a trace viewer
+ *
+ * `ASTRUM_PROFILE_SCOPE("name")` times the rest of the enclosing block, and
+ * `ASTRUM_PROFILE_FUNCTION()` the rest of the enclosing function. Names must
+ * be string literals, or otherwise outlive the recording. Each thread records
+ * into a buffer of its own, without locking; a thread whose buffer is full
+ * drops further scopes. Buffers grow in chunks of `EVENTS_PER_CHUNK`, so a
+ * short-lived thread, like a timer's, costs a few kilobytes. `dump` writes everything recorded in the Chrome
+ * trace-event format, which Perfetto (ui.perfetto.dev) and `chrome://tracing`
+ * open.
+ */
+namespace profile {
+
+	/**
+	 * @brief Scopes each thread can record before dropping more.
+	 */
+	constexpr std::size_t EVENTS_PER_THREAD = 1 << 16;
+	/**
+	 * @brief Scopes allocated at a time as a thread's buffer grows.
+	 */
+	constexpr std::size_t EVENTS_PER_CHUNK = 1 << 10;
+
+	/**
+	 * @brief Whether scopes are compiled in.
+	 */
+	constexpr bool ENABLED =
+#ifdef ASTRUM_PROFILE
+		true;
+#else
+		false;
+#endif
+
+	std::uint64_t now();
+	void record(const char *name, std::uint64_t start, std::uint64_t end);
+
+	/**
+	 * @brief Write every recorded scope to a trace-event JSON file.
+	 *
+	 * @return Whether the file could be written.
+	 */
+	bool dump(const std::filesystem::path &path);
+	/**
+	 * @brief Forget every recorded scope.
+	 *
+	 * Scopes being recorded by other threads at the same time may survive.
+	 */
+	void clear();
+	/**
+	 * @brief The number of scopes dropped because a buffer was full.
+	 */
+	std::uint64_t getDroppedCount();
+
+	/**
+	 * @brief Records the time between its construction and destruction.
+	 *
+	 * Usually created through `ASTRUM_PROFILE_SCOPE`.
+	 */
+	class Scope {
+	private:
+		const char *name;
+		std::uint64_t start;
+
+	public:
+		explicit Scope(const char *name) : name(name), start(now()) { }
+		Scope(const Scope &src) = delete;
+		Scope &operator=(const Scope &src) = delete;
+		~Scope() {
+			record(this->name, this->start, now());
+		}
+	};
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_PROFILE
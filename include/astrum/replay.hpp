@@ -0,0 +1,83 @@
+#ifndef INCLUDE_ASTRUM_REPLAY
+#define INCLUDE_ASTRUM_REPLAY
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include "constants.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Input recording and deterministic playback
+ *
+ * A recording holds every SDL event that reached the event handler, the `dt`
+ * passed to each `update`, and every seed given to `math::randomseed`. Playing
+ * it back feeds the same events through the same path with the same `dt`, so a
+ * session can be re-run against different builds and its frame times compared.
+ *
+ * Playback is started through `Config::replayInput`, usually together with
+ * `Config::headless` and `Config::unlimitedFrameRate`; `Astrum::quit` is
+ * called once the last recorded frame has run.
+ *
+ * The file starts with the 8 bytes `ASTRREC1` and the initial seed (32-bit).
+ * After that come tagged records: `F` followed by a frame's `dt` (a double),
+ * `E` followed by an event's size (8-bit) and that many bytes of the event
+ * (drop events are followed by a 32-bit length and the path), `S` followed
+ * by a 32-bit seed, and `P` followed by a gamepad's instance ID (32-bit), its
+ * axis count (8-bit), that many axes (floats) and its held buttons (a 32-bit
+ * mask). A `P` record follows the added event of each gamepad that could be
+ * opened. Controller- and joystick-added events store the instance ID in
+ * `which`, rather than the device index SDL gives them. Values are stored in
+ * native byte order.
+ */
+namespace replay {
+
+	/**
+	 * @brief Start recording to a file.
+	 *
+	 * Starting a recording reseeds the random number generator, so that the
+	 * recording is reproducible from its first frame. Does nothing if a
+	 * recording is already running.
+	 *
+	 * @param path The file to write; overwritten if it exists.
+	 * @return false if the file couldn't be opened.
+	 */
+	bool startRecording(std::filesystem::path path);
+	/**
+	 * @brief Stop recording and close the file.
+	 *
+	 * Also called by `Astrum::exit`.
+	 */
+	void stopRecording();
+	bool isRecording();
+
+	bool isReplaying();
+	/**
+	 * @brief The index of the frame being played back.
+	 */
+	std::size_t getFrame();
+	/**
+	 * @brief The number of frames in the recording being played back.
+	 */
+	std::size_t getFrameCount();
+	/**
+	 * @brief Measured wall-clock time of each played-back frame, in seconds.
+	 *
+	 * Unlike the recorded `dt`, which is what `update` sees, these are the
+	 * real times each frame took in this build.
+	 */
+	const std::vector<double> &getFrameTimes();
+	/**
+	 * @brief Write the measured frame times to a file, one per line.
+	 *
+	 * @return false if the file couldn't be written.
+	 */
+	bool saveFrameTimes(std::filesystem::path path);
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_REPLAY
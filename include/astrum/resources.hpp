@@ -0,0 +1,127 @@
+#ifndef INCLUDE_ASTRUM_RESOURCES
+#define INCLUDE_ASTRUM_RESOURCES
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+#include "event.hpp"
+#include "font.hpp"
+#include "image.hpp"
+
+namespace Astrum {
+
+enum class ResourceType { image, texture, font, cursor, sound };
+
+/**
+ * @brief The live resources of one type.
+ *
+ * `bytes` is the size of the pixel or sample data: surface pixels for
+ * images, an estimate of 4 bytes per pixel for textures, and decoded PCM for
+ * sounds. Fonts and cursors are only counted.
+ */
+struct ResourceUsage {
+	std::size_t count = 0;
+	std::size_t bytes = 0;
+};
+
+/**
+ * @brief One live resource.
+ *
+ * `name` is the path a resource was loaded from, and empty otherwise.
+ */
+struct ResourceInfo {
+	ResourceType type;
+	std::size_t bytes;
+	std::string name;
+};
+
+/**
+ * @brief Keeps count of every image, texture, font, cursor and sound
+ *
+ * Resources register themselves when created and unregister when their last
+ * reference goes away. Each type can be given a soft memory budget: crossing
+ * it logs a warning and calls the `overbudget` listeners, which can free
+ * resources to get back under it. Whatever is still live once `Astrum::exit`
+ * has released Astrum's own resources is logged, to help find leaks.
+ *
+ * Images and fonts loaded from a path are also cached, keyed by the
+ * normalized path and, for fonts, the size and style. Loading one again
+ * while an earlier load is still live shares its pixels or glyphs instead
+ * of reading the file again. Transforms, colour and alignment stay each
+ * handle's own, as if the file had been read twice. The cache itself only
+ * holds weak references, unless a resource was preloaded.
+ */
+namespace resources {
+
+	ResourceUsage getUsage(ResourceType type);
+	/**
+	 * @brief The bytes held by every type together.
+	 */
+	std::size_t getTotalBytes();
+	/**
+	 * @brief Every live resource, in no particular order.
+	 */
+	std::vector<ResourceInfo> getLive();
+
+	/**
+	 * @brief Get the soft budget for a type, in bytes.
+	 *
+	 * 0, the default, means no budget.
+	 */
+	std::size_t getBudget(ResourceType type);
+	void setBudget(ResourceType type, std::size_t bytes);
+
+	/**
+	 * @brief Log the usage of every type, and each live resource.
+	 *
+	 * The totals are logged as `info` and the resources as `debug`.
+	 */
+	void dump();
+
+	/**
+	 * @brief Called when a type goes over its budget.
+	 *
+	 * Receives the type, its current size and its budget. Called once each
+	 * time the budget is crossed, on the thread that created the resource.
+	 */
+	extern Listeners<ResourceType, std::size_t, std::size_t> overbudget;
+
+	template <typename F>
+	ListenerToken onoverbudget(F &&cb, int priority = 0) {
+		return overbudget.add(std::forward<F>(cb), priority);
+	}
+
+	/**
+	 * @brief Load an image now, and keep it loaded until `purge`.
+	 *
+	 * Later `Image(path)` calls share it instead of reading the file.
+	 */
+	Image preloadImage(const std::string &path);
+	/**
+	 * @brief Load a font now, and keep it loaded until `purge`.
+	 *
+	 * Later `Font(path, ...)` calls with the same size and style share it,
+	 * whatever their colour and alignment.
+	 */
+	Font preloadFont(const std::string &path, int size = 18,
+		int style = Font::NORMAL);
+	/**
+	 * @brief Release every preloaded resource.
+	 *
+	 * Resources still referenced elsewhere stay live, and stay shared by
+	 * later loads until their last reference goes away.
+	 */
+	void purge();
+	/**
+	 * @brief The number of cached resources that are still live.
+	 */
+	std::size_t getCachedCount();
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_RESOURCES
@@ -0,0 +1,101 @@
+#ifndef INCLUDE_ASTRUM_TELEMETRY
+#define INCLUDE_ASTRUM_TELEMETRY
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "constants.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief Records per-frame statistics to a file, for offline analysis
+ *
+ * While recording, one record per frame is appended to
+ * `telemetry/frames-<date>-<time>.csv` (or `.json`) in the app directory. The
+ * file is written by a background thread in large batches, so recording costs
+ * the frame little more than copying a few counters. When recording stops
+ * (at the latest in `Astrum::exit`), a summary of the frame times is logged
+ * and written next to the data as `<name>-summary.json`.
+ */
+namespace telemetry {
+
+	enum class Format { csv, json };
+
+	/**
+	 * @brief Everything recorded about one frame.
+	 *
+	 * Times are in milliseconds. `frameTime` runs from the start of one frame
+	 * to the start of the next, so it includes waiting for vsync; the phase
+	 * times cover handling events, `update` (including gamepad refreshes),
+	 * `draw` callbacks and presenting. `allocations` counts calls to
+	 * `operator new`, and is always 0 unless the library was built with the
+	 * `ASTRUM_COUNT_ALLOCATIONS` CMake option.
+	 */
+	struct FrameRecord {
+		std::uint64_t frame = 0;
+		double frameTime = 0.0;
+		double eventsTime = 0.0;
+		double updateTime = 0.0;
+		double drawTime = 0.0;
+		double presentTime = 0.0;
+		std::uint32_t events = 0;
+		std::uint32_t drawCalls = 0;
+		std::uint32_t textureUploads = 0;
+		std::uint32_t textRasterizations = 0;
+		std::uint64_t allocations = 0;
+	};
+
+	/**
+	 * @brief Frame time figures for a recording, in milliseconds.
+	 *
+	 * `hitches` counts frames slower than the hitch threshold.
+	 */
+	struct Summary {
+		std::size_t frames = 0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+		std::size_t hitches = 0;
+	};
+
+	/**
+	 * @brief Start recording to a new file.
+	 *
+	 * Call after `Astrum::init`. Does nothing if already recording.
+	 *
+	 * @return Whether the file could be created.
+	 */
+	bool start(Format format = Format::csv);
+	/**
+	 * @brief Stop recording, and write and log the summary.
+	 */
+	void stop();
+	bool isRecording();
+	/**
+	 * @brief The file being recorded to, or the last one if stopped.
+	 */
+	std::filesystem::path getPath();
+	/**
+	 * @brief The summary of the current or last recording.
+	 */
+	Summary getSummary();
+
+	/**
+	 * @brief Get the frame time above which a frame counts as a hitch.
+	 *
+	 * In milliseconds; defaults to 33.3, twice a 60 Hz frame. Kept fixed
+	 * rather than relative to the median so that results from different
+	 * machines can be compared directly.
+	 */
+	double getHitchThreshold();
+	void setHitchThreshold(double ms);
+
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_TELEMETRY
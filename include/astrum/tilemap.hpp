@@ -0,0 +1,86 @@
+#ifndef INCLUDE_ASTRUM_TILEMAP
+#define INCLUDE_ASTRUM_TILEMAP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "constants.hpp"
+#include "image.hpp"
+
+namespace Astrum {
+
+/**
+ * @brief A large grid of tiles, drawn a chunk at a time
+ *
+ * The map is split into square chunks of tiles. Each chunk is drawn once
+ * into a texture of its own, and redrawn only after one of its tiles
+ * changes, so a frame costs one texture copy per chunk on screen however
+ * many tiles the map has. Chunks outside the screen are skipped, and the
+ * textures of chunks not drawn for a while are released once more than
+ * `getMaxCachedChunks` exist.
+ *
+ * Tiles are numbered from 1, with 0 being empty. With a tileset, tile `n`
+ * is the `n`th tile of the image, counting left to right, then top to
+ * bottom. Without one, each tile is a rectangle of its colour from
+ * `setTileColor`.
+ *
+ * Copies share the same tiles, like copies of an `Image`.
+ */
+class TileMap {
+private:
+	std::shared_ptr<struct TileMapData> data;
+
+public:
+	using Tile = std::uint16_t;
+	static constexpr Tile EMPTY = 0;
+
+	TileMap(int width, int height, int tileWidth, int tileHeight,
+		int chunkSize = 32);
+	TileMap(Image tileset, int width, int height, int tileWidth,
+		int tileHeight, int chunkSize = 32);
+
+	Tile get(int x, int y) const;
+	/**
+	 * @brief Set a tile; tiles outside the map are ignored.
+	 */
+	void set(int x, int y, Tile tile);
+	void fill(Tile tile);
+	/**
+	 * @brief The colour drawn for `tile` when there is no tileset.
+	 */
+	void setTileColor(Tile tile, Color color);
+
+	/**
+	 * @brief Draw the map with its top-left corner at `x, y`.
+	 *
+	 * Goes through the graphics transform; only chunks landing on the view
+	 * are drawn.
+	 */
+	void draw(float x = 0.0f, float y = 0.0f) const;
+	/**
+	 * @brief Redraw every chunk on its next draw.
+	 *
+	 * Needed after the renderer loses its render targets, which SDL reports
+	 * with an `SDL_RENDER_TARGETS_RESET` event.
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Width in tiles.
+	 */
+	int getWidth() const;
+	/**
+	 * @brief Height in tiles.
+	 */
+	int getHeight() const;
+	int getTileWidth() const;
+	int getTileHeight() const;
+	int getChunkSize() const;
+	std::size_t getMaxCachedChunks() const;
+	void setMaxCachedChunks(std::size_t count);
+};
+
+}; // namespace Astrum
+
+#endif // ifndef INCLUDE_ASTRUM_TILEMAP
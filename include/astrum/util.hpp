@@ -2,11 +2,144 @@
 #define INCLUDE_ASTRUM_UTIL
 
 #include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
 
 #include "constants.hpp"
 
+// lets GCC and Clang check printf-style arguments against the format string
+#if defined(__GNUC__) || defined(__clang__)
+#	define ASTRUM_PRINTF(formatIdx, argsIdx) \
+		__attribute__((format(printf, formatIdx, argsIdx)))
+#else
+#	define ASTRUM_PRINTF(formatIdx, argsIdx)
+#endif
+
 namespace Astrum {
 
+/**
+ * @brief A non-owning view of a contiguous array.
+ *
+ * A small stand-in for C++20's `std::span`, used by functions that take many
+ * items at once. Can be built from a pointer and a length, a C array, or any
+ * container with `data()` and `size()` (`std::vector`, `std::array`, ...).
+ * The viewed memory must outlive the span.
+ */
+template <typename T>
+class Span {
+private:
+	T *ptr = nullptr;
+	std::size_t len = 0;
+
+public:
+	using value_type = std::remove_cv_t<T>;
+
+	constexpr Span() = default;
+	constexpr Span(T *ptr, std::size_t len) : ptr(ptr), len(len) { }
+	template <std::size_t N>
+	constexpr Span(T (&arr)[N]) : ptr(arr), len(N) { }
+	template <typename C, typename = std::enable_if_t<
+		!std::is_same_v<std::decay_t<C>, Span>
+		&& std::is_convertible_v<decltype(std::declval<C &>().data()), T *>>>
+	constexpr Span(C &&container)
+		: ptr(container.data()), len(container.size()) { }
+
+	constexpr T *data() const {
+		return this->ptr;
+	}
+	constexpr std::size_t size() const {
+		return this->len;
+	}
+	constexpr bool empty() const {
+		return this->len == 0;
+	}
+	constexpr T *begin() const {
+		return this->ptr;
+	}
+	constexpr T *end() const {
+		return this->ptr + this->len;
+	}
+	constexpr T &operator[](std::size_t idx) const {
+		return this->ptr[idx];
+	}
+	constexpr Span subspan(std::size_t offset, std::size_t count) const {
+		return Span(this->ptr + offset, count);
+	}
+};
+
+/**
+ * @brief A string formatted into a fixed-size buffer of its own.
+ *
+ * Meant for text rebuilt every frame, like a HUD: formatting never allocates.
+ * Output longer than `N - 1` bytes is truncated. Like `util::strformat`, the
+ * arguments are checked against the format string at compile time.
+ */
+template <std::size_t N>
+class FixedString {
+	static_assert(N > 0, "FixedString needs room for the terminator");
+
+private:
+	char buf[N] = { };
+	std::size_t len = 0;
+
+public:
+	FixedString() = default;
+
+	/**
+	 * @brief Replace the contents with a printf-formatted string.
+	 */
+	FixedString &format(const char *format, ...) ASTRUM_PRINTF(2, 3) {
+		std::va_list args;
+		va_start(args, format);
+		this->len = 0;
+		this->vappend(format, args);
+		va_end(args);
+		return *this;
+	}
+	/**
+	 * @brief Append a printf-formatted string.
+	 */
+	FixedString &append(const char *format, ...) ASTRUM_PRINTF(2, 3) {
+		std::va_list args;
+		va_start(args, format);
+		this->vappend(format, args);
+		va_end(args);
+		return *this;
+	}
+	FixedString &vappend(const char *format, std::va_list args) {
+		int out = std::vsnprintf(this->buf + this->len, N - this->len,
+			format, args);
+		if (out > 0)
+			this->len = std::min(this->len + out, N - 1);
+		this->buf[this->len] = '\0';
+		return *this;
+	}
+	void clear() {
+		this->len = 0;
+		this->buf[0] = '\0';
+	}
+
+	const char *c_str() const {
+		return this->buf;
+	}
+	std::string_view view() const {
+		return std::string_view(this->buf, this->len);
+	}
+	std::size_t size() const {
+		return this->len;
+	}
+	bool empty() const {
+		return this->len == 0;
+	}
+	static constexpr std::size_t capacity() {
+		return N - 1;
+	}
+};
+
 /**
  * @brief General-purpose utility functions that don't fit anywhere else.
  *
@@ -20,12 +153,13 @@ namespace util {
 	 *
 	 * Creates and returns a formatted string, using printf format strings.
 	 * Takes the format string and any number of parameters to use in
-	 * formatting.
+	 * formatting. Output that fits in a small stack buffer is formatted in a
+	 * single pass, without an intermediate heap buffer.
 	 *
 	 * @param format The format string to use.
 	 * @return A printf-formatted string using the arguments.
 	 */
-	std::string strformat(std::string format, ...);
+	std::string strformat(const char *format, ...) ASTRUM_PRINTF(1, 2);
 
 	/**
 	 * @brief Create a formatted string using a `va_list`.
@@ -38,7 +172,8 @@ namespace util {
 	 * @param args A `va_list` containing all arguments to format with.
 	 * @return A printf-formatted string using the arguments.
 	 */
-	std::string vstrformat(std::string format, std::va_list args);
+	std::string vstrformat(const char *format, std::va_list args)
+		ASTRUM_PRINTF(1, 0);
 
 }
 
@@ -2,6 +2,7 @@
 #	include <emscripten.h>
 #endif
 
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <filesystem>
@@ -9,6 +10,7 @@
 #include <vector>
 #include <utility>
 #include <stdexcept>
+#include <algorithm>
 
 #include "sdl.hpp"
 #include "internals.hpp"
@@ -23,6 +25,12 @@
 #include "astrum/log.hpp"
 #include "astrum/filesystem.hpp"
 #include "astrum/timer.hpp"
+#include "astrum/event.hpp"
+#include "astrum/gamepad.hpp"
+#include "astrum/replay.hpp"
+#include "astrum/telemetry.hpp"
+#include "astrum/profile.hpp"
+#include "astrum/resources.hpp"
 
 namespace Astrum {
 
@@ -38,31 +46,49 @@ const int DEFAULT_HEIGHT = 480;
 bool hasInit = false;
 std::vector<std::pair<void *, std::function<void(void *)>>> dropQueue;
 
+namespace event {
+	Listeners<> quit;
+	Listeners<> draw;
+	Listeners<> startup;
+	Listeners<int, int> resize;
+	Listeners<bool> visible;
+	Listeners<bool> focus;
+	Listeners<int, int> moved;
+	Listeners<Key, KeyMod, bool> keypressed;
+	Listeners<Key> keyreleased;
+	Listeners<const std::string &> textinput;
+	Listeners<const std::string &, int, int> textedited;
+	Listeners<int, int, int, int> mousemoved;
+	Listeners<Span<const MouseMotion>> mousemotionraw;
+	Listeners<MouseButton, int, int, int> mousepressed;
+	Listeners<MouseButton, int, int, int> mousereleased;
+	Listeners<int, int> wheelmoved;
+	Listeners<bool> mousefocus;
+	Listeners<const std::filesystem::path &> filedropped;
+	Listeners<const std::filesystem::path &> directorydropped;
+	Listeners<int> gamepadadded;
+	Listeners<int> gamepadremoved;
+	Listeners<int, GamepadAxis, float> gamepadaxis;
+	Listeners<int, GamepadButton> gamepadpressed;
+	Listeners<int, GamepadButton> gamepadreleased;
+	Listeners<int> joystickadded;
+	Listeners<int> joystickremoved;
+	Listeners<int, int, float> joystickaxis;
+	Listeners<int, int, int> joystickhat;
+	Listeners<int, int> joystickpressed;
+	Listeners<int, int> joystickreleased;
+};
+
 namespace {
 	bool isrunning = false;
+	bool unlimitedFrameRate = false;
+	bool presentAfterDraw = false;
 
-	std::optional<std::function<void()> > startupCb;
-	std::optional<std::function<void()> > drawCb;
-	std::optional<std::function<void()> > quitCb;
-	std::optional<std::function<void(int, int)> > resizeCb;
-	std::optional<std::function<void(bool)> > visibleCb;
-	std::optional<std::function<void(bool)> > focusCb;
-	std::optional<std::function<void(int, int)> > movedCb;
-	std::optional<std::function<void(Key, KeyMod, bool)> > keypressedCb;
-	std::optional<std::function<void(Key)> > keyreleasedCb;
-	std::optional<std::function<void(std::string)> > textinputCb;
-	std::optional<std::function<void(std::string, int, int)> > texteditedCb;
-	std::optional<std::function<void(int, int, int, int)> > mousemovedCb;
-	std::optional<std::function<void(MouseButton, int, int, int)> > mousepressedCb;
-	std::optional<std::function<void(MouseButton, int, int, int)> > mousereleasedCb;
-	std::optional<std::function<void(int, int)> > wheelmovedCb;
-	std::optional<std::function<void(bool)> > mousefocusCb;
-	std::optional<std::function<void(std::filesystem::path)> > filedroppedCb;
-	std::optional<std::function<void(std::filesystem::path)> > directorydroppedCb;
 	std::function<void(double)> updateCb;
 };
 
 bool handleEvent(const SDL_Event &e) {
+	ASTRUM_PROFILE_FUNCTION();
 	int virtX, virtY;
 	Key key;
 	KeyMod mod;
@@ -71,8 +97,7 @@ bool handleEvent(const SDL_Event &e) {
 	switch (e.type) {
 	case SDL_QUIT:
 		doquit = true;
-		if (quitCb)
-			(*quitCb)();
+		event::quit.dispatch();
 		break;
 	case SDL_KEYDOWN:
 		if (e.key.repeat && !keyboard::hasKeyRepeat())
@@ -80,81 +105,71 @@ bool handleEvent(const SDL_Event &e) {
 		key = fromKeycode(e.key.keysym.sym);
 		mod = fromSDLMod(e.key.keysym.mod);
 		keyboard::addKeydown(key);
-		if (keypressedCb)
-			(*keypressedCb)(key, mod, (bool) e.key.repeat);
+		event::keypressed.dispatch(key, mod, (bool) e.key.repeat);
 		break;
 	case SDL_KEYUP:
 		key = fromKeycode(e.key.keysym.sym);
 		keyboard::removeKeydown(key);
-		if (keyreleasedCb)
-			(*keyreleasedCb)(key);
+		event::keyreleased.dispatch(key);
 		break;
 	case SDL_TEXTEDITING:
-		if (texteditedCb)
-			(*texteditedCb)(e.edit.text, e.edit.start, e.edit.length);
+		if (!event::textedited.empty())
+			event::textedited.dispatch(e.edit.text, e.edit.start,
+				e.edit.length);
 		break;
 	case SDL_TEXTINPUT:
-		if (textinputCb)
-			(*textinputCb)(e.edit.text);
+		if (!event::textinput.empty())
+			event::textinput.dispatch(e.text.text);
 		break;
 	case SDL_MOUSEMOTION:
-		std::tie(virtX, virtY) = graphics::getVirtualCoords(e.motion.x, e.motion.y);
-		if (mousemovedCb)
-			(*mousemovedCb)(virtX, virtY, e.motion.xrel, e.motion.yrel);
+		mouse::addMotion(e);
 		break;
 	case SDL_MOUSEBUTTONDOWN:
+		// motion so far has to be seen before the click
+		mouse::flushMotion();
 		btn = fromMouseBtn(e.button.button);
 		std::tie(virtX, virtY) = graphics::getVirtualCoords(e.button.x, e.button.y);
 		mouse::addMousedown(btn);
-		if (mousepressedCb)
-			(*mousepressedCb)(btn, virtX, virtY, e.button.clicks);
+		event::mousepressed.dispatch(btn, virtX, virtY, e.button.clicks);
 		break;
 	case SDL_MOUSEBUTTONUP:
+		mouse::flushMotion();
 		btn = fromMouseBtn(e.button.button);
 		std::tie(virtX, virtY) = graphics::getVirtualCoords(e.button.x, e.button.y);
 		mouse::removeMousedown(btn);
-		if (mousereleasedCb)
-			(*mousereleasedCb)(btn, virtX, virtY, e.button.clicks);
+		event::mousereleased.dispatch(btn, virtX, virtY, e.button.clicks);
 		break;
 	case SDL_MOUSEWHEEL: {
+		mouse::flushMotion();
 		int mul = e.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -1 : 1;
-		if (wheelmovedCb)
-			(*wheelmovedCb)(e.wheel.x * mul, e.wheel.y * mul);
+		event::wheelmoved.dispatch(e.wheel.x * mul, e.wheel.y * mul);
 		break;
 	}
 	case SDL_WINDOWEVENT:
 		switch (e.window.event) {
 		case SDL_WINDOWEVENT_SHOWN:
-			if (visibleCb)
-				(*visibleCb)(true);
+			event::visible.dispatch(true);
 			break;
 		case SDL_WINDOWEVENT_HIDDEN:
-			if (visibleCb)
-				(*visibleCb)(false);
+			event::visible.dispatch(false);
 			break;
 		case SDL_WINDOWEVENT_MOVED:
-			if (movedCb)
-				(*movedCb)(e.window.data1, e.window.data2);
+			event::moved.dispatch(e.window.data1, e.window.data2);
 			break;
 		case SDL_WINDOWEVENT_RESIZED:
-			if (resizeCb)
-				(*resizeCb)(e.window.data1, e.window.data2);
+			event::resize.dispatch(e.window.data1, e.window.data2);
 			break;
 		case SDL_WINDOWEVENT_FOCUS_GAINED:
-			if (focusCb)
-				(*focusCb)(true);
+			event::focus.dispatch(true);
 			break;
 		case SDL_WINDOWEVENT_FOCUS_LOST:
-			if (focusCb)
-				(*focusCb)(false);
+			event::focus.dispatch(false);
 			break;
 		case SDL_WINDOWEVENT_ENTER:
-			if (mousefocusCb)
-				(*mousefocusCb)(true);
+			event::mousefocus.dispatch(true);
 			break;
 		case SDL_WINDOWEVENT_LEAVE:
-			if (mousefocusCb)
-				(*mousefocusCb)(false);
+			event::mousefocus.dispatch(false);
 			break;
 		case SDL_WINDOWEVENT_MAXIMIZED:
 		case SDL_WINDOWEVENT_RESTORED:
@@ -163,16 +178,28 @@ bool handleEvent(const SDL_Event &e) {
 			break;
 		}
 		break;
+	case SDL_CONTROLLERDEVICEADDED:
+	case SDL_CONTROLLERDEVICEREMOVED:
+	case SDL_CONTROLLERAXISMOTION:
+	case SDL_CONTROLLERBUTTONDOWN:
+	case SDL_CONTROLLERBUTTONUP:
+		gamepad::handleGamepadEvent(e);
+		break;
+	case SDL_JOYDEVICEADDED:
+	case SDL_JOYDEVICEREMOVED:
+	case SDL_JOYAXISMOTION:
+	case SDL_JOYHATMOTION:
+	case SDL_JOYBUTTONDOWN:
+	case SDL_JOYBUTTONUP:
+		gamepad::handleJoystickEvent(e);
+		break;
 	case SDL_DROPFILE:
 		std::filesystem::path p(e.drop.file);
 		bool isdir = std::filesystem::is_directory(p);
-		if (isdir) {
-			if (directorydroppedCb)
-				(*directorydroppedCb)(p);
-		} else {
-			if (filedroppedCb)
-				(*filedroppedCb)(p);
-		}
+		if (isdir)
+			event::directorydropped.dispatch(p);
+		else
+			event::filedropped.dispatch(p);
 		SDL_free(e.drop.file);
 		break;
 	}
@@ -184,6 +211,10 @@ void init(const Config &conf) {
 		return;
 
 	SDL_SetMainReady();
+	if (conf.headless)
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+	unlimitedFrameRate = conf.unlimitedFrameRate;
+	presentAfterDraw = conf.presentAfterDraw;
 	int init = SDL_Init(SDL_INIT_TIMER | SDL_INIT_AUDIO | SDL_INIT_VIDEO
 		| SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER);
 	if (init != 0) {
@@ -214,6 +245,7 @@ void init(const Config &conf) {
 	mouse::InitMouse();
 	math::InitMath();
 	timer::InitTimer();
+	replay::InitReplay(conf);
 
 	for (auto [ptr, dropFunc] : dropQueue) {
 		dropFunc(ptr);
@@ -231,9 +263,20 @@ void exit() {
 	if (!hasInit)
 		return;
 
+	telemetry::QuitTelemetry();
+	replay::QuitReplay();
+	gamepad::QuitGamepad();
+	mouse::QuitMouse();
 	window::QuitWindow();
+	// preloaded resources are Astrum's to release, and their textures have
+	// to go before the renderer does
+	resources::purge();
 	graphics::QuitGraphics();
 	filesystem::QuitFS();
+	// anything still live is held by the game
+	resources::dump();
+	log::stopAsync();
+	log::closeFile();
 
 	SDL_Quit();
 	TTF_Quit();
@@ -243,25 +286,69 @@ void exit() {
 }
 
 void mainLoop() {
+	ASTRUM_PROFILE_SCOPE("frame");
 	SDL_Event e;
+	telemetry::frameStarted();
+	graphics::frameStarted();
 	double dt = timer::step();
+	bool doquit = false;
+	std::uint32_t handled = 0;
+
+	if (replay::isReplaying()) {
+		if (replay::nextFrame(dt, dt))
+			timer::setDelta(dt);
+		else
+			quit();
+		while (!doquit && replay::pollEvent(&e)) {
+			doquit = handleEvent(e);
+			handled++;
+		}
+		// real input is ignored during a replay, apart from quitting
+		while (!doquit && SDL_PollEvent(&e)) {
+			if (e.type == SDL_QUIT)
+				doquit = handleEvent(e);
+			else if (e.type == SDL_DROPFILE || e.type == SDL_DROPTEXT)
+				SDL_free(e.drop.file);
+		}
+	} else {
+		replay::recordFrame(dt);
+		while (!doquit && SDL_PollEvent(&e)) {
+			replay::recordEvent(e);
+			latency::stamp(e);
+			doquit = handleEvent(e);
+			handled++;
+		}
+	}
 
-	while (SDL_PollEvent(&e)) {
-		bool doquit = handleEvent(e);
-		if (doquit) {
+	if (doquit) {
 #ifdef __EMSCRIPTEN__
-			emscripten_cancel_main_loop();
+		emscripten_cancel_main_loop();
 #endif
-			isrunning = false;
-			return;
-		}
+		isrunning = false;
+		return;
 	}
 
-	updateCb(dt);
+	mouse::flushMotion();
+	telemetry::eventsHandled(handled);
+	telemetry::phaseDone(telemetry::Phase::events);
 
-	graphics::drawframe();
-	if (drawCb)
-		(*drawCb)();
+	gamepad::refresh();
+	updateCb(dt);
+	telemetry::phaseDone(telemetry::Phase::update);
+
+	if (presentAfterDraw) {
+		event::draw.dispatch();
+		telemetry::phaseDone(telemetry::Phase::draw);
+		latency::frameDrawn();
+		graphics::drawframe();
+		telemetry::phaseDone(telemetry::Phase::present);
+	} else {
+		graphics::drawframe();
+		telemetry::phaseDone(telemetry::Phase::present);
+		event::draw.dispatch();
+		telemetry::phaseDone(telemetry::Phase::draw);
+		latency::frameDrawn();
+	}
 };
 
 void run(std::function<void(double)> update) {
@@ -270,8 +357,7 @@ void run(std::function<void(double)> update) {
 
 	isrunning = true;
 
-	if (startupCb)
-		(*startupCb)();
+	event::startup.dispatch();
 
 	// don't count time from start-up function in dt
 	timer::step();
@@ -281,7 +367,8 @@ void run(std::function<void(double)> update) {
 	emscripten_set_main_loop(mainLoop, 0, 1);
 #else
 	while (isrunning) {
-		SDL_Delay(1);
+		if (!unlimitedFrameRate)
+			SDL_Delay(1);
 		mainLoop();
 	}
 #endif
@@ -300,130 +387,4 @@ void quit() {
 	SDL_PushEvent(&e);
 }
 
-void onquit(std::function<void()> cb) {
-	quitCb = cb;
-}
-
-void ondraw(std::function<void()> cb) {
-	drawCb = cb;
-}
-
-void onkeypressed(std::function<void(Key, KeyMod, bool)> cb) {
-	keypressedCb = cb;
-}
-void onkeypressed(std::function<void(Key, KeyMod)> cb) {
-	auto lambda = [cb](Key k, KeyMod m, bool UNUSED(r)) { cb(k, m); };
-	keypressedCb = lambda;
-}
-void onkeypressed(std::function<void(Key)> cb) {
-	auto lambda = [cb](Key k, KeyMod UNUSED(m), bool UNUSED(r)) { cb(k); };
-	keypressedCb = lambda;
-}
-
-void onkeyreleased(std::function<void(Key)> cb) {
-	keyreleasedCb = cb;
-}
-
-void onresize(std::function<void(int, int)> cb) {
-	resizeCb = cb;
-}
-
-void onvisible(std::function<void(bool)> cb) {
-	visibleCb = cb;
-}
-
-void onfocus(std::function<void(bool)> cb) {
-	focusCb = cb;
-}
-
-void onmoved(std::function<void(int, int)> cb) {
-	movedCb = cb;
-}
-
-void ontextinput(std::function<void(std::string)> cb) {
-	textinputCb = cb;
-}
-
-void ontextedited(std::function<void(std::string, int, int)> cb) {
-	texteditedCb = cb;
-}
-void ontextedited(std::function<void(std::string, int)> cb) {
-	auto lambda = [cb](std::string text, int start, int UNUSED(length)) { cb(text, start); };
-	texteditedCb = lambda;
-}
-void ontextedited(std::function<void(std::string)> cb) {
-	auto lambda = [cb](std::string text, int UNUSED(start), int UNUSED(length)) { cb(text); };
-	texteditedCb = lambda;
-}
-
-void onmousemoved(std::function<void(int, int, int, int)> cb) {
-	mousemovedCb = cb;
-}
-void onmousemoved(std::function<void(int, int)> cb) {
-	auto lambda = [cb](int x, int y, int UNUSED(dx), int UNUSED(dy)) { cb(x, y); };
-	mousemovedCb = lambda;
-}
-
-void onmousepressed(std::function<void(MouseButton, int, int, int)> cb) {
-	mousepressedCb = cb;
-}
-void onmousepressed(std::function<void(MouseButton, int, int)> cb) {
-	auto lambda = [cb](MouseButton button, int x, int y, int UNUSED(clicks)) { cb(button, x, y); };
-	mousepressedCb = lambda;
-}
-void onmousepressed(std::function<void(MouseButton)> cb) {
-	auto lambda = [cb](MouseButton button, int UNUSED(x), int UNUSED(y), int UNUSED(clicks)) { cb(button); };
-	mousepressedCb = lambda;
-}
-
-void onmousereleased(std::function<void(MouseButton, int, int, int)> cb) {
-	mousereleasedCb = cb;
-}
-void onmousereleased(std::function<void(MouseButton, int, int)> cb) {
-	auto lambda = [cb](MouseButton button, int x, int y, int UNUSED(clicks)) { cb(button, x, y); };
-	mousereleasedCb = lambda;
-}
-void onmousereleased(std::function<void(MouseButton)> cb) {
-	auto lambda = [cb](MouseButton button, int UNUSED(x), int UNUSED(y), int UNUSED(clicks)) { cb(button); };
-	mousereleasedCb = lambda;
-}
-
-void onwheelmoved(std::function<void(int, int)> cb) {
-	wheelmovedCb = cb;
-}
-
-void onmousefocus(std::function<void(bool)> cb) {
-	mousefocusCb = cb;
-}
-
-void onfiledropped(std::function<void(std::filesystem::path)> cb) {
-	filedroppedCb = cb;
-}
-void onfiledropped(std::function<void(std::string)> cb) {
-	auto lambda = [cb](std::filesystem::path p) { cb(p.string()); };
-	filedroppedCb = lambda;
-}
-
-void ondirectorydropped(std::function<void(std::filesystem::path)> cb) {
-	directorydroppedCb = cb;
-}
-void ondirectorydropped(std::function<void(std::string)> cb) {
-	auto lambda = [cb](std::filesystem::path p) { cb(p.string()); };
-	directorydroppedCb = lambda;
-}
-
-void onstartup(std::function<void()> cb) {
-	startupCb = cb;
-}
-
-void ongamepadaxis();
-void ongamepadpressed();
-void ongamepadreleased();
-void onjoystickadded();
-void onjoystickaxis();
-void onjoystickhat();
-void onjoystickpressed();
-void onjoystickreleased();
-void onjoystickremoved();
-
 }; // namespace Astrum
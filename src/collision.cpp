@@ -0,0 +1,412 @@
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "astrum/collision.hpp"
+#include "astrum/math.hpp"
+#include "astrum/util.hpp"
+
+namespace Astrum {
+
+namespace collision {
+
+	SpatialHash::SpatialHash(float cellSize, std::size_t buckets)
+		: cellSize(cellSize), invCellSize(1.0f / cellSize) {
+		std::size_t size = 1;
+		while (size < buckets)
+			size <<= 1;
+		this->bucketMask = static_cast<std::uint32_t>(size - 1);
+		this->heads.assign(size, -1);
+	}
+
+	SpatialHash::CellRange SpatialHash::cellsOf(const Rect &rect) const {
+		return CellRange {
+			static_cast<std::int32_t>(std::floor(rect.x * this->invCellSize)),
+			static_cast<std::int32_t>(std::floor(rect.y * this->invCellSize)),
+			static_cast<std::int32_t>(std::floor(rect.right() * this->invCellSize)),
+			static_cast<std::int32_t>(std::floor(rect.bottom() * this->invCellSize))
+		};
+	}
+
+	std::uint32_t SpatialHash::bucketOf(std::int32_t cx, std::int32_t cy) const {
+		std::uint32_t h = static_cast<std::uint32_t>(cx) * 0x9E3779B1u
+			^ static_cast<std::uint32_t>(cy) * 0x85EBCA77u;
+		return (h ^ (h >> 15)) & this->bucketMask;
+	}
+
+	void SpatialHash::link(Id id, const CellRange &range) {
+		for (std::int32_t cy = range.minY; cy <= range.maxY; cy++) {
+			for (std::int32_t cx = range.minX; cx <= range.maxX; cx++) {
+				std::int32_t idx;
+				if (this->freeNodes >= 0) {
+					idx = this->freeNodes;
+					this->freeNodes = this->nodes[idx].next;
+				} else {
+					idx = static_cast<std::int32_t>(this->nodes.size());
+					this->nodes.emplace_back();
+				}
+				std::int32_t &head = this->heads[this->bucketOf(cx, cy)];
+				this->nodes[idx] = Node { id, cx, cy, head };
+				head = idx;
+			}
+		}
+	}
+
+	void SpatialHash::unlink(Id id, const CellRange &range) {
+		for (std::int32_t cy = range.minY; cy <= range.maxY; cy++) {
+			for (std::int32_t cx = range.minX; cx <= range.maxX; cx++) {
+				std::int32_t *link = &this->heads[this->bucketOf(cx, cy)];
+				while (*link >= 0) {
+					Node &node = this->nodes[*link];
+					if (node.id == id && node.cx == cx && node.cy == cy) {
+						std::int32_t idx = *link;
+						*link = node.next;
+						node.next = this->freeNodes;
+						this->freeNodes = idx;
+						break;
+					}
+					link = &node.next;
+				}
+			}
+		}
+	}
+
+	std::uint32_t SpatialHash::nextQuery() const {
+		if (++this->query == 0) {
+			std::fill(this->stamps.begin(), this->stamps.end(), 0);
+			this->query = 1;
+		}
+		return this->query;
+	}
+
+	template <typename F>
+	void SpatialHash::visitCell(std::int32_t cx, std::int32_t cy,
+		std::uint32_t stamp, F &&found) const {
+		std::int32_t idx = this->heads[this->bucketOf(cx, cy)];
+		while (idx >= 0) {
+			const Node &node = this->nodes[idx];
+			// other cells can share the bucket
+			if (node.cx == cx && node.cy == cy
+				&& this->stamps[node.id] != stamp) {
+				this->stamps[node.id] = stamp;
+				found(node.id);
+			}
+			idx = node.next;
+		}
+	}
+
+	template <typename F>
+	void SpatialHash::visit(const CellRange &range, F &&found) const {
+		std::uint32_t stamp = this->nextQuery();
+		std::uint64_t cells = static_cast<std::uint64_t>(range.maxX - range.minX + 1)
+			* static_cast<std::uint64_t>(range.maxY - range.minY + 1);
+		if (cells <= this->heads.size()) {
+			for (std::int32_t cy = range.minY; cy <= range.maxY; cy++) {
+				for (std::int32_t cx = range.minX; cx <= range.maxX; cx++)
+					this->visitCell(cx, cy, stamp, found);
+			}
+			return;
+		}
+		// a huge area has more cells than there are buckets, so it's faster
+		// to go through every node
+		for (std::int32_t head : this->heads) {
+			for (std::int32_t idx = head; idx >= 0; idx = this->nodes[idx].next) {
+				const Node &node = this->nodes[idx];
+				if (node.cx >= range.minX && node.cx <= range.maxX
+					&& node.cy >= range.minY && node.cy <= range.maxY
+					&& this->stamps[node.id] != stamp) {
+					this->stamps[node.id] = stamp;
+					found(node.id);
+				}
+			}
+		}
+	}
+
+	void SpatialHash::rebuild(Span<const Rect> objects) {
+		std::size_t num = objects.size();
+		this->bounds.assign(objects.begin(), objects.end());
+		this->ranges.resize(num);
+		this->present.assign(num, 1);
+		this->stamps.assign(num, 0);
+		this->query = 0;
+		this->count = num;
+		this->freeNodes = -1;
+
+		// a counting sort by bucket, so each bucket's nodes are contiguous
+		std::size_t buckets = this->heads.size();
+		this->offsets.assign(buckets + 1, 0);
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < num; i++) {
+			CellRange range = this->cellsOf(objects[i]);
+			this->ranges[i] = range;
+			for (std::int32_t cy = range.minY; cy <= range.maxY; cy++) {
+				for (std::int32_t cx = range.minX; cx <= range.maxX; cx++)
+					this->offsets[this->bucketOf(cx, cy)]++;
+			}
+			total += static_cast<std::size_t>(range.maxX - range.minX + 1)
+				* (range.maxY - range.minY + 1);
+		}
+		// each offset becomes the end of its bucket, then counts back down
+		// to the start as the bucket is filled
+		std::int32_t end = 0;
+		for (std::size_t b = 0; b < buckets; b++) {
+			end += this->offsets[b];
+			this->offsets[b] = end;
+		}
+		this->offsets[buckets] = end;
+		this->nodes.resize(total);
+		for (std::size_t i = 0; i < num; i++) {
+			const CellRange &range = this->ranges[i];
+			for (std::int32_t cy = range.minY; cy <= range.maxY; cy++) {
+				for (std::int32_t cx = range.minX; cx <= range.maxX; cx++) {
+					std::int32_t idx = --this->offsets[this->bucketOf(cx, cy)];
+					this->nodes[idx] = Node { static_cast<Id>(i), cx, cy, idx + 1 };
+				}
+			}
+		}
+		for (std::size_t b = 0; b < buckets; b++) {
+			std::int32_t start = this->offsets[b];
+			std::int32_t stop = this->offsets[b + 1];
+			if (start == stop) {
+				this->heads[b] = -1;
+			} else {
+				this->heads[b] = start;
+				this->nodes[stop - 1].next = -1;
+			}
+		}
+	}
+
+	void SpatialHash::clear() {
+		std::fill(this->heads.begin(), this->heads.end(), -1);
+		this->nodes.clear();
+		this->freeNodes = -1;
+		this->bounds.clear();
+		this->ranges.clear();
+		this->present.clear();
+		this->stamps.clear();
+		this->count = 0;
+	}
+
+	void SpatialHash::insert(Id id, const Rect &rect) {
+		if (id < this->present.size() && this->present[id]) {
+			this->update(id, rect);
+			return;
+		}
+		if (id >= this->present.size()) {
+			this->bounds.resize(id + 1);
+			this->ranges.resize(id + 1);
+			this->present.resize(id + 1, 0);
+			this->stamps.resize(id + 1, 0);
+		}
+		CellRange range = this->cellsOf(rect);
+		this->bounds[id] = rect;
+		this->ranges[id] = range;
+		this->present[id] = 1;
+		this->count++;
+		this->link(id, range);
+	}
+
+	void SpatialHash::update(Id id, const Rect &rect) {
+		if (id >= this->present.size() || !this->present[id]) {
+			this->insert(id, rect);
+			return;
+		}
+		this->bounds[id] = rect;
+		CellRange range = this->cellsOf(rect);
+		const CellRange &old = this->ranges[id];
+		if (range.minX == old.minX && range.minY == old.minY
+			&& range.maxX == old.maxX && range.maxY == old.maxY)
+			return;
+		this->unlink(id, old);
+		this->link(id, range);
+		this->ranges[id] = range;
+	}
+
+	void SpatialHash::remove(Id id) {
+		if (!this->contains(id))
+			return;
+		this->unlink(id, this->ranges[id]);
+		this->present[id] = 0;
+		this->count--;
+	}
+
+	bool SpatialHash::contains(Id id) const {
+		return id < this->present.size() && this->present[id];
+	}
+
+	Rect SpatialHash::getBounds(Id id) const {
+		return this->bounds[id];
+	}
+
+	std::size_t SpatialHash::size() const {
+		return this->count;
+	}
+
+	float SpatialHash::getCellSize() const {
+		return this->cellSize;
+	}
+
+	std::size_t SpatialHash::queryRect(const Rect &area, Span<Id> out) const {
+		std::size_t found = 0;
+		this->visit(this->cellsOf(area), [&](Id id) {
+			if (!this->bounds[id].intersects(area))
+				return;
+			if (found < out.size())
+				out[found] = id;
+			found++;
+		});
+		return found;
+	}
+
+	std::size_t SpatialHash::queryCircle(Vec2 center, float radius,
+		Span<Id> out) const {
+		std::size_t found = 0;
+		Rect area(center.x - radius, center.y - radius, radius * 2, radius * 2);
+		float radius2 = radius * radius;
+		this->visit(this->cellsOf(area), [&](Id id) {
+			const Rect &rect = this->bounds[id];
+			Vec2 closest(std::clamp(center.x, rect.x, rect.right()),
+				std::clamp(center.y, rect.y, rect.bottom()));
+			if ((closest - center).lengthSquared() >= radius2)
+				return;
+			if (found < out.size())
+				out[found] = id;
+			found++;
+		});
+		return found;
+	}
+
+	std::size_t SpatialHash::queryPoint(Vec2 point, Span<Id> out) const {
+		std::size_t found = 0;
+		std::int32_t cx = static_cast<std::int32_t>(
+			std::floor(point.x * this->invCellSize));
+		std::int32_t cy = static_cast<std::int32_t>(
+			std::floor(point.y * this->invCellSize));
+		this->visitCell(cx, cy, this->nextQuery(), [&](Id id) {
+			if (!this->bounds[id].contains(point))
+				return;
+			if (found < out.size())
+				out[found] = id;
+			found++;
+		});
+		return found;
+	}
+
+	// narrows [enter, exit] to where the ray is between `low` and `high` on
+	// one axis
+	static void clipSlab(float low, float high, float origin, float dir,
+		float invDir, float &enter, float &exit) {
+		if (dir == 0.0f) {
+			if (origin < low || origin > high)
+				exit = -1.0f;
+			return;
+		}
+		float t1 = (low - origin) * invDir;
+		float t2 = (high - origin) * invDir;
+		enter = std::max(enter, std::min(t1, t2));
+		exit = std::min(exit, std::max(t1, t2));
+	}
+
+	// the slab test: the distance at which the ray enters `rect`, or a
+	// negative value if it misses within `maxDistance`
+	static float rayEnters(const Rect &rect, Vec2 origin, Vec2 dir, Vec2 invDir,
+		float maxDistance) {
+		float enter = 0.0f;
+		float exit = maxDistance;
+		clipSlab(rect.x, rect.right(), origin.x, dir.x, invDir.x, enter, exit);
+		clipSlab(rect.y, rect.bottom(), origin.y, dir.y, invDir.y, enter, exit);
+		return enter <= exit ? enter : -1.0f;
+	}
+
+	std::size_t SpatialHash::queryRay(Vec2 origin, Vec2 dir, float maxDistance,
+		Span<RayHit> out) const {
+		std::size_t found = 0;
+		Vec2 invDir(1.0f / dir.x, 1.0f / dir.y);
+		auto test = [&](Id id) {
+			float distance = rayEnters(this->bounds[id], origin, dir, invDir,
+				maxDistance);
+			if (distance < 0.0f)
+				return;
+			if (found < out.size())
+				out[found] = RayHit { id, distance };
+			found++;
+		};
+
+		// walk the cells the ray passes through, nearest first
+		// (Amanatides & Woo)
+		std::int32_t cx = static_cast<std::int32_t>(
+			std::floor(origin.x * this->invCellSize));
+		std::int32_t cy = static_cast<std::int32_t>(
+			std::floor(origin.y * this->invCellSize));
+		std::int32_t stepX = dir.x > 0.0f ? 1 : -1;
+		std::int32_t stepY = dir.y > 0.0f ? 1 : -1;
+		constexpr float inf = std::numeric_limits<float>::infinity();
+		float deltaX = dir.x == 0.0f ? inf : this->cellSize * std::fabs(invDir.x);
+		float deltaY = dir.y == 0.0f ? inf : this->cellSize * std::fabs(invDir.y);
+		float nextX = dir.x == 0.0f ? inf
+			: ((cx + (stepX > 0 ? 1 : 0)) * this->cellSize - origin.x) * invDir.x;
+		float nextY = dir.y == 0.0f ? inf
+			: ((cy + (stepY > 0 ? 1 : 0)) * this->cellSize - origin.y) * invDir.y;
+		std::uint32_t stamp = this->nextQuery();
+		while (true) {
+			this->visitCell(cx, cy, stamp, test);
+			if (nextX < nextY) {
+				if (nextX > maxDistance)
+					break;
+				cx += stepX;
+				nextX += deltaX;
+			} else {
+				if (nextY > maxDistance)
+					break;
+				cy += stepY;
+				nextY += deltaY;
+			}
+		}
+
+		std::size_t written = std::min(found, out.size());
+		std::sort(out.begin(), out.begin() + written,
+			[](const RayHit &a, const RayHit &b) {
+				return a.distance < b.distance;
+			});
+		return found;
+	}
+
+	std::size_t SpatialHash::pairs(Span<Pair> out) const {
+		std::size_t found = 0;
+		for (std::int32_t head : this->heads) {
+			for (std::int32_t i = head; i >= 0; i = this->nodes[i].next) {
+				const Node &first = this->nodes[i];
+				const Rect &firstRect = this->bounds[first.id];
+				for (std::int32_t j = first.next; j >= 0; j = this->nodes[j].next) {
+					const Node &second = this->nodes[j];
+					if (second.cx != first.cx || second.cy != first.cy)
+						continue;
+					const Rect &secondRect = this->bounds[second.id];
+					if (!firstRect.intersects(secondRect))
+						continue;
+					// objects sharing several cells are only reported from
+					// the cell holding the top-left of their overlap
+					float left = std::max(firstRect.x, secondRect.x);
+					float top = std::max(firstRect.y, secondRect.y);
+					if (static_cast<std::int32_t>(std::floor(left * this->invCellSize)) != first.cx
+						|| static_cast<std::int32_t>(std::floor(top * this->invCellSize)) != first.cy)
+						continue;
+					if (found < out.size()) {
+						out[found] = first.id < second.id
+							? Pair { first.id, second.id }
+							: Pair { second.id, first.id };
+					}
+					found++;
+				}
+			}
+		}
+		return found;
+	}
+
+};
+
+}; // namespace Astrum
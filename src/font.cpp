@@ -13,6 +13,7 @@
 #include "astrum/util.hpp"
 #include "astrum/image.hpp"
 #include "astrum/graphics.hpp"
+#include "astrum/profile.hpp"
 
 #ifndef NO_DEFAULT_FONT
 #	include "vera_ttf.h"
@@ -25,6 +26,7 @@ std::shared_ptr<FontData> fontDataFromRW(SDL_RWops *rw, int size, Color color,
 	if (rw == nullptr) {
 		return std::make_shared<FontData>(nullptr, color, align);
 	} else {
+		ASTRUM_PROFILE_SCOPE("Font load");
 		TTF_Font *font = TTF_OpenFontRW(rw, 1, size);
 		TTF_SetFontStyle(font, style & ~Font::OUTLINE);
 		if (style & Font::OUTLINE)
@@ -45,6 +47,15 @@ Font::Font(int size, Color color, int style, TextAlign align) {
 #endif
 
 Font::Font(std::string path, int size, Color color, int style, TextAlign align) {
+	std::string key = resources::fontKey(path, size, style);
+	auto loaded = std::static_pointer_cast<FontData>(
+		resources::findCached(key));
+	if (loaded != nullptr) {
+		// the glyphs are shared, the colour and alignment are not
+		this->data = std::make_shared<FontData>(loaded, color, align);
+		return;
+	}
+	ASTRUM_PROFILE_SCOPE("Font load");
 	TTF_Font *font = TTF_OpenFont(path.c_str(), size);
 	if (font == nullptr) {
 		this->data = std::make_shared<FontData>(nullptr, color, align);
@@ -53,7 +64,10 @@ Font::Font(std::string path, int size, Color color, int style, TextAlign align)
 	TTF_SetFontStyle(font, style & ~OUTLINE);
 	if (style & OUTLINE)
 		TTF_SetFontOutline(font, 1);
-	this->data = std::make_shared<FontData>(font, color, align);
+	loaded = std::make_shared<FontData>(font, color, align);
+	resources::describe(loaded.get(), path);
+	loaded = std::static_pointer_cast<FontData>(resources::cache(key, loaded));
+	this->data = std::make_shared<FontData>(loaded, color, align);
 }
 Font::Font(std::filesystem::path path, int size, Color color, int style,
 	TextAlign align) : Font(path.string(), size, color, style, align) { };
@@ -70,25 +84,35 @@ std::shared_ptr<FontData> Font::getData() {
 	return this->data;
 }
 
-Image Font::renderText(std::string text) const {
+Image Font::renderText(const char *text) const {
 	return this->renderText(text, this->data->defaultColor);
 }
-Image Font::renderText(std::string text, Color color) const {
+Image Font::renderText(const char *text, Color color) const {
 	SDL_Color scol = { color.r, color.g, color.b, color.a };
-	SDL_Surface *surf = TTF_RenderUTF8_Solid(this->data->font, text.c_str(),
-		scol);
+	ASTRUM_PROFILE_SCOPE("Font::renderText");
+	SDL_Surface *surf = TTF_RenderUTF8_Solid(this->data->font, text, scol);
+	graphics::stats.textRasterizations++;
 	auto data = std::make_shared<ImageData>(surf);
 	return Image(data);
 }
+Image Font::renderText(const std::string &text) const {
+	return this->renderText(text.c_str(), this->data->defaultColor);
+}
+Image Font::renderText(const std::string &text, Color color) const {
+	return this->renderText(text.c_str(), color);
+}
 
-std::tuple<int, int> Font::textSize(std::string text) const {
+std::tuple<int, int> Font::textSize(const char *text) const {
 	int width, height;
-	int out = TTF_SizeUTF8(this->data->font, text.c_str(), &width, &height);
+	int out = TTF_SizeUTF8(this->data->font, text, &width, &height);
 	if (out != 0) {
 		throw std::runtime_error("Failed to get text size");
 	}
 	return std::make_tuple(width, height);
 }
+std::tuple<int, int> Font::textSize(const std::string &text) const {
+	return this->textSize(text.c_str());
+}
 
 Color Font::getColor() const {
 	return this->data->defaultColor;
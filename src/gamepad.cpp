@@ -0,0 +1,316 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/gamepad.hpp"
+#include "astrum/event.hpp"
+#include "astrum/replay.hpp"
+
+namespace Astrum {
+
+namespace gamepad {
+
+	namespace {
+		constexpr int AXES = GamepadState::AXIS_COUNT;
+
+		// a replayed pad takes a slot without an SDL controller behind it
+		bool used[MAX_GAMEPADS] = { };
+		SDL_GameController *controllers[MAX_GAMEPADS] = { };
+		SDL_JoystickID ids[MAX_GAMEPADS];
+		GamepadState states[MAX_GAMEPADS];
+		const GamepadState disconnected;
+
+		// written by events as they arrive, read once per frame; kept flat
+		// so the deadzone pass runs over every axis of every slot at once
+		float rawAxes[MAX_GAMEPADS * AXES] = { };
+		float filteredAxes[MAX_GAMEPADS * AXES] = { };
+		std::uint32_t heldButtons[MAX_GAMEPADS] = { };
+		std::uint32_t downEvents[MAX_GAMEPADS] = { };
+		std::uint32_t upEvents[MAX_GAMEPADS] = { };
+
+		float deadzone = 0.15f;
+
+		// joysticks that aren't gamepads, opened so SDL sends their events;
+		// gamepads open their joystick themselves
+		constexpr int MAX_JOYSTICKS = 8;
+		SDL_Joystick *joysticks[MAX_JOYSTICKS] = { };
+		SDL_JoystickID joystickIds[MAX_JOYSTICKS];
+	};
+
+	static float normalizeAxis(Sint16 value) {
+		return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+	}
+
+	static float applyDeadzone(float value, float zone, float scale) {
+		float magnitude = std::max(std::fabs(value) - zone, 0.0f) * scale;
+		return std::copysign(magnitude, value);
+	}
+
+	static int slotFor(SDL_JoystickID id) {
+		for (int i = 0; i < MAX_GAMEPADS; i++) {
+			if (used[i] && ids[i] == id)
+				return i;
+		}
+		return -1;
+	}
+
+	static int freeSlot(SDL_JoystickID id) {
+		if (slotFor(id) >= 0)
+			return -1;
+		for (int i = 0; i < MAX_GAMEPADS; i++) {
+			if (!used[i])
+				return i;
+		}
+		return -1;
+	}
+
+	static int addController(int deviceIdx) {
+		SDL_JoystickID id = SDL_JoystickGetDeviceInstanceID(deviceIdx);
+		int slot = freeSlot(id);
+		if (slot < 0)
+			return -1;
+		SDL_GameController *controller = SDL_GameControllerOpen(deviceIdx);
+		if (controller == nullptr)
+			return -1;
+		used[slot] = true;
+		controllers[slot] = controller;
+		ids[slot] = id;
+
+		// pick up whatever is already held
+		for (int axis = 0; axis < AXES; axis++) {
+			rawAxes[slot * AXES + axis] = normalizeAxis(
+				SDL_GameControllerGetAxis(controller,
+				static_cast<SDL_GameControllerAxis>(axis)));
+		}
+		std::uint32_t held = 0;
+		for (int btn = 0; btn < SDL_CONTROLLER_BUTTON_MAX; btn++) {
+			if (SDL_GameControllerGetButton(controller,
+				static_cast<SDL_GameControllerButton>(btn)))
+				held |= 1u << btn;
+		}
+		heldButtons[slot] = held;
+		downEvents[slot] = upEvents[slot] = 0;
+		// a replay can't query the pad, so it gets this state from the file
+		replay::recordGamepad(id, rawAxes + slot * AXES, AXES, held);
+		return slot;
+	}
+
+	// the recorded event holds the instance id, and the state it was added
+	// with follows it in the recording
+	static int addReplayed(SDL_JoystickID id) {
+		int slot = freeSlot(id);
+		if (slot < 0)
+			return -1;
+		std::uint32_t held;
+		if (!replay::nextGamepad(id, rawAxes + slot * AXES, AXES, held))
+			return -1;
+		used[slot] = true;
+		ids[slot] = id;
+		heldButtons[slot] = held;
+		downEvents[slot] = upEvents[slot] = 0;
+		return slot;
+	}
+
+	static int removeController(SDL_JoystickID id) {
+		int slot = slotFor(id);
+		if (slot < 0)
+			return -1;
+		if (controllers[slot] != nullptr)
+			SDL_GameControllerClose(controllers[slot]);
+		controllers[slot] = nullptr;
+		used[slot] = false;
+		std::fill_n(rawAxes + slot * AXES, AXES, 0.0f);
+		heldButtons[slot] = downEvents[slot] = upEvents[slot] = 0;
+		return slot;
+	}
+
+	static void openJoystick(int deviceIdx) {
+		if (SDL_IsGameController(deviceIdx))
+			return;
+		for (int i = 0; i < MAX_JOYSTICKS; i++) {
+			if (joysticks[i] != nullptr)
+				continue;
+			joysticks[i] = SDL_JoystickOpen(deviceIdx);
+			if (joysticks[i] != nullptr)
+				joystickIds[i] = SDL_JoystickInstanceID(joysticks[i]);
+			return;
+		}
+	}
+
+	static void closeJoystick(SDL_JoystickID id) {
+		for (int i = 0; i < MAX_JOYSTICKS; i++) {
+			if (joysticks[i] != nullptr && joystickIds[i] == id) {
+				SDL_JoystickClose(joysticks[i]);
+				joysticks[i] = nullptr;
+				return;
+			}
+		}
+	}
+
+	void QuitGamepad() {
+		for (int i = 0; i < MAX_JOYSTICKS; i++) {
+			if (joysticks[i] != nullptr)
+				SDL_JoystickClose(joysticks[i]);
+			joysticks[i] = nullptr;
+		}
+		for (int i = 0; i < MAX_GAMEPADS; i++) {
+			if (controllers[i] != nullptr)
+				SDL_GameControllerClose(controllers[i]);
+			controllers[i] = nullptr;
+			used[i] = false;
+			states[i] = GamepadState();
+		}
+		std::fill_n(rawAxes, MAX_GAMEPADS * AXES, 0.0f);
+	}
+
+	void handleGamepadEvent(const SDL_Event &e) {
+		int slot;
+		float value;
+		GamepadButton button;
+		switch (e.type) {
+		case SDL_CONTROLLERDEVICEADDED:
+			slot = replay::isReplaying() ? addReplayed(e.cdevice.which)
+				: addController(e.cdevice.which);
+			if (slot >= 0)
+				event::gamepadadded.dispatch(slot);
+			break;
+		case SDL_CONTROLLERDEVICEREMOVED:
+			slot = removeController(e.cdevice.which);
+			if (slot >= 0)
+				event::gamepadremoved.dispatch(slot);
+			break;
+		case SDL_CONTROLLERAXISMOTION:
+			slot = slotFor(e.caxis.which);
+			if (slot < 0 || e.caxis.axis >= AXES)
+				break;
+			value = normalizeAxis(e.caxis.value);
+			rawAxes[slot * AXES + e.caxis.axis] = value;
+			if (!event::gamepadaxis.empty()) {
+				value = applyDeadzone(value, deadzone,
+					1.0f / (1.0f - deadzone));
+				event::gamepadaxis.dispatch(slot,
+					static_cast<GamepadAxis>(e.caxis.axis), value);
+			}
+			break;
+		case SDL_CONTROLLERBUTTONDOWN:
+			slot = slotFor(e.cbutton.which);
+			if (slot < 0 || e.cbutton.button >= 32)
+				break;
+			heldButtons[slot] |= 1u << e.cbutton.button;
+			downEvents[slot] |= 1u << e.cbutton.button;
+			button = static_cast<GamepadButton>(e.cbutton.button);
+			event::gamepadpressed.dispatch(slot, button);
+			break;
+		case SDL_CONTROLLERBUTTONUP:
+			slot = slotFor(e.cbutton.which);
+			if (slot < 0 || e.cbutton.button >= 32)
+				break;
+			heldButtons[slot] &= ~(1u << e.cbutton.button);
+			upEvents[slot] |= 1u << e.cbutton.button;
+			button = static_cast<GamepadButton>(e.cbutton.button);
+			event::gamepadreleased.dispatch(slot, button);
+			break;
+		}
+	}
+
+	void handleJoystickEvent(const SDL_Event &e) {
+		switch (e.type) {
+		case SDL_JOYDEVICEADDED:
+			// recordings store the instance ID, and a replay has no device
+			if (replay::isReplaying()) {
+				event::joystickadded.dispatch(e.jdevice.which);
+				break;
+			}
+			openJoystick(e.jdevice.which);
+			// `which` is a device index here, but an instance ID everywhere
+			// else
+			event::joystickadded.dispatch(
+				SDL_JoystickGetDeviceInstanceID(e.jdevice.which));
+			break;
+		case SDL_JOYDEVICEREMOVED:
+			closeJoystick(e.jdevice.which);
+			event::joystickremoved.dispatch(e.jdevice.which);
+			break;
+		case SDL_JOYAXISMOTION:
+			event::joystickaxis.dispatch(e.jaxis.which, e.jaxis.axis,
+				std::max(e.jaxis.value / 32767.0f, -1.0f));
+			break;
+		case SDL_JOYHATMOTION:
+			event::joystickhat.dispatch(e.jhat.which, e.jhat.hat, e.jhat.value);
+			break;
+		case SDL_JOYBUTTONDOWN:
+			event::joystickpressed.dispatch(e.jbutton.which, e.jbutton.button);
+			break;
+		case SDL_JOYBUTTONUP:
+			event::joystickreleased.dispatch(e.jbutton.which, e.jbutton.button);
+			break;
+		}
+	}
+
+	void refresh() {
+		const float zone = deadzone;
+		const float scale = 1.0f / (1.0f - zone);
+		// branch-free so the compiler can vectorize it
+		for (int i = 0; i < MAX_GAMEPADS * AXES; i++)
+			filteredAxes[i] = applyDeadzone(rawAxes[i], zone, scale);
+
+		for (int i = 0; i < MAX_GAMEPADS; i++) {
+			GamepadState &state = states[i];
+			state.connected = used[i];
+			std::memcpy(state.axes, filteredAxes + i * AXES,
+				sizeof(state.axes));
+			state.buttons = heldButtons[i];
+			state.pressed = downEvents[i];
+			state.released = upEvents[i];
+			downEvents[i] = upEvents[i] = 0;
+		}
+	}
+
+	int getCount() {
+		int count = 0;
+		for (int i = 0; i < MAX_GAMEPADS; i++)
+			count += used[i];
+		return count;
+	}
+
+	bool isConnected(int index) {
+		return getState(index).connected;
+	}
+
+	const GamepadState &getState(int index) {
+		if (index < 0 || index >= MAX_GAMEPADS)
+			return disconnected;
+		return states[index];
+	}
+
+	bool isdown(int index, GamepadButton button) {
+		return getState(index).isdown(button);
+	}
+
+	float getAxis(int index, GamepadAxis axis) {
+		return getState(index).axis(axis);
+	}
+
+	std::string getName(int index) {
+		if (index < 0 || index >= MAX_GAMEPADS || controllers[index] == nullptr)
+			return "";
+		const char *name = SDL_GameControllerName(controllers[index]);
+		return name == nullptr ? "" : std::string(name);
+	}
+
+	float getDeadzone() {
+		return deadzone;
+	}
+
+	void setDeadzone(float zone) {
+		deadzone = std::clamp(zone, 0.0f, 0.99f);
+	}
+
+};
+
+}; // namespace Astrum
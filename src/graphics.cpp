@@ -1,10 +1,15 @@
 #include <cstdio>
+#include <cmath>
 #include <vector>
+#include <algorithm>
 #include <assert.h>
 #include <cstdint>
+#include <iterator>
+#include <optional>
 #include <string>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
 
 #include "sdl.hpp"
 #include "internals.hpp"
@@ -14,6 +19,9 @@
 #include "astrum/font.hpp"
 #include "astrum/astrum.hpp"
 #include "astrum/util.hpp"
+#include "astrum/math.hpp"
+#include "astrum/log.hpp"
+#include "astrum/profile.hpp"
 
 namespace Astrum {
 
@@ -28,7 +36,11 @@ std::uint32_t Color::toHex() const {
 }
 
 namespace graphics {
+	Stats stats;
+
 	namespace {
+		constexpr float RADIANS_PER_DEGREE = 3.14159265f / 180.0f;
+
 		SDL_Renderer *renderer;
 //		void *glcontext;
 		Font defaultFont;
@@ -36,11 +48,314 @@ namespace graphics {
 		Color backgroundColor;
 		Color currentColor;
 		int lineThickness;
+
+		Stats budget;
+
+		// the current transform, and those saved by `push`
+		Mat3 transform;
+		std::vector<Mat3> transformStack;
+		// whether `transform` only translates, so images keep their shape
+		bool translateOnly = true;
+		std::optional<Rect> scissor;
+		// the whole screen, and the part of it draws can reach
+		Rect screen;
+		Rect view;
+		// shapes that can't be drawn as they are once transformed are
+		// drawn as polygons, built here
+		std::vector<Sint16> polyX;
+		std::vector<Sint16> polyY;
+		// lines and points once transformed, kept between calls
+		std::vector<SDL_FPoint> screenPoints;
+		std::vector<SDL_Vertex> lineVertices;
+		std::vector<int> lineIndices;
+
+		// beyond this many colours, coloured points are drawn as geometry
+		constexpr std::size_t MAX_POINT_GROUPS = 16;
+		struct PointGroup {
+			Color color;
+			std::vector<SDL_FPoint> points;
+		};
+		// only the first few are in use, the rest keep their capacity
+		std::vector<PointGroup> pointGroups;
 	};
 
+	static void countPrimitive() {
+		stats.drawCalls++;
+		stats.gfxPrimitives++;
+	}
+
+	static int toPixel(float v) {
+		return static_cast<int>(std::floor(v + 0.5f));
+	}
+
+	static void transformChanged() {
+		translateOnly = transform.a == 1.0f && transform.b == 0.0f
+			&& transform.c == 0.0f && transform.d == 1.0f;
+	}
+
+	static bool isAxisAligned() {
+		return transform.b == 0.0f && transform.c == 0.0f;
+	}
+
+	static void updateView() {
+		int w = 0, h = 0;
+		SDL_RenderGetLogicalSize(renderer, &w, &h);
+		if (w == 0 || h == 0)
+			SDL_GetRendererOutputSize(renderer, &w, &h);
+		screen = Rect(0.0f, 0.0f, w, h);
+		view = screen;
+		if (scissor) {
+			float left = std::max(view.left(), scissor->left());
+			float top = std::max(view.top(), scissor->top());
+			float right = std::min(view.right(), scissor->right());
+			float bottom = std::min(view.bottom(), scissor->bottom());
+			view = Rect(left, top, std::max(right - left, 0.0f),
+				std::max(bottom - top, 0.0f));
+		}
+	}
+
+	// the margin covers line thickness and rounding
+	bool cull(const Rect &bounds) {
+		float margin = std::max(lineThickness, 1) / 2.0f + 1.0f;
+		if (bounds.right() + margin >= view.left()
+			&& bounds.left() - margin <= view.right()
+			&& bounds.bottom() + margin >= view.top()
+			&& bounds.top() - margin <= view.bottom())
+			return false;
+		stats.culled++;
+		return true;
+	}
+
+	static bool culled(const Rect &local) {
+		return cull(transform.applyRect(local));
+	}
+
+	// a quad of `texture` through `m`, with texture coordinates `uv`
+	static bool drawQuad(SDL_Texture *texture, const Mat3 &m, const Rect &quad,
+		const Rect &uv, Color col) {
+		const SDL_Color tint = { col.r, col.g, col.b, col.a };
+		Vec2 p0 = m.apply(Vec2(quad.left(), quad.top()));
+		Vec2 p1 = m.apply(Vec2(quad.right(), quad.top()));
+		Vec2 p2 = m.apply(Vec2(quad.right(), quad.bottom()));
+		Vec2 p3 = m.apply(Vec2(quad.left(), quad.bottom()));
+		const SDL_Vertex vertices[] = {
+			{ { p0.x, p0.y }, tint, { uv.left(), uv.top() } },
+			{ { p1.x, p1.y }, tint, { uv.right(), uv.top() } },
+			{ { p2.x, p2.y }, tint, { uv.right(), uv.bottom() } },
+			{ { p3.x, p3.y }, tint, { uv.left(), uv.bottom() } },
+		};
+		const int indices[] = { 0, 1, 2, 0, 2, 3 };
+		return geometry(texture, vertices, indices);
+	}
+
+	static Rect boundsOf(const int *coords, std::size_t points) {
+		float minX = coords[0], maxX = coords[0];
+		float minY = coords[1], maxY = coords[1];
+		for (std::size_t i = 1; i < points; i++) {
+			minX = std::min<float>(minX, coords[i * 2]);
+			maxX = std::max<float>(maxX, coords[i * 2]);
+			minY = std::min<float>(minY, coords[i * 2 + 1]);
+			maxY = std::max<float>(maxY, coords[i * 2 + 1]);
+		}
+		return Rect(minX, minY, maxX - minX, maxY - minY);
+	}
+
+	static Rect boundsOf(Span<const Vec2> points) {
+		float minX = points[0].x, maxX = points[0].x;
+		float minY = points[0].y, maxY = points[0].y;
+		for (Vec2 p : points) {
+			minX = std::min(minX, p.x);
+			maxX = std::max(maxX, p.x);
+			minY = std::min(minY, p.y);
+			maxY = std::max(maxY, p.y);
+		}
+		return Rect(minX, minY, maxX - minX, maxY - minY);
+	}
+
+	// what SDL2_gfx does before drawing
+	static void setDrawColor(Color col) {
+		SDL_SetRenderDrawBlendMode(renderer,
+			col.a == 0xFF ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+		SDL_SetRenderDrawColor(renderer, col.r, col.g, col.b, col.a);
+	}
+
+	static void addLinePoint(Vec2 point) {
+		Vec2 p = transform.apply(point);
+		screenPoints.push_back({ p.x, p.y });
+	}
+
+	// a quad `lineThickness` wide along each pair of `screenPoints`, either
+	// joining every point to the next or taking them two at a time
+	static void drawThickLines(bool joined, Color col) {
+		const SDL_Color tint = { col.r, col.g, col.b, col.a };
+		float half = lineThickness / 2.0f;
+		std::size_t step = joined ? 1 : 2;
+		lineVertices.clear();
+		lineIndices.clear();
+		for (std::size_t i = 0; i + 1 < screenPoints.size(); i += step) {
+			Vec2 from(screenPoints[i].x, screenPoints[i].y);
+			Vec2 to(screenPoints[i + 1].x, screenPoints[i + 1].y);
+			Vec2 along = to - from;
+			if (along.x == 0.0f && along.y == 0.0f)
+				continue;
+			Vec2 side = Vec2(-along.y, along.x).normalized() * half;
+			int base = static_cast<int>(lineVertices.size());
+			for (Vec2 p : { from - side, to - side, to + side, from + side })
+				lineVertices.push_back({ { p.x, p.y }, tint, { 0.0f, 0.0f } });
+			lineIndices.insert(lineIndices.end(),
+				{ base, base + 1, base + 2, base, base + 2, base + 3 });
+		}
+		geometry(nullptr, lineVertices, lineIndices);
+		screenPoints.clear();
+	}
+
+	// joins every point in `screenPoints` to the next
+	static void drawLineStrip(Color col) {
+		if (lineThickness > 1) {
+			drawThickLines(true, col);
+			return;
+		}
+		setDrawColor(col);
+		SDL_RenderDrawLinesF(renderer, screenPoints.data(),
+			static_cast<int>(screenPoints.size()));
+		stats.drawCalls++;
+		screenPoints.clear();
+	}
+
+	// where `point` lands on screen, or false if it misses the view
+	static bool toScreen(Vec2 point, SDL_FPoint &out) {
+		Vec2 p = translateOnly
+			? Vec2(point.x + transform.tx, point.y + transform.ty)
+			: transform.apply(point);
+		if (p.x < view.left() || p.x >= view.right() || p.y < view.top()
+			|| p.y >= view.bottom())
+			return false;
+		out = { p.x, p.y };
+		return true;
+	}
+
+	static std::uint32_t packColor(Color col) {
+		return static_cast<std::uint32_t>(col.r) << 24
+			| static_cast<std::uint32_t>(col.g) << 16
+			| static_cast<std::uint32_t>(col.b) << 8 | col.a;
+	}
+
+	// each point as a pixel-sized quad, all in one geometry call
+	static void drawPointQuads(Span<const Point> points) {
+		lineVertices.resize(points.size() * 4);
+		lineIndices.resize(points.size() * 6);
+		SDL_Vertex *vert = lineVertices.data();
+		int *index = lineIndices.data();
+		int base = 0;
+		for (const Point &point : points) {
+			SDL_FPoint p;
+			if (!toScreen(point.position, p))
+				continue;
+			float x = std::floor(p.x);
+			float y = std::floor(p.y);
+			const SDL_Color col = { point.color.r, point.color.g, point.color.b,
+				point.color.a };
+			vert[0] = { { x, y }, col, { 0.0f, 0.0f } };
+			vert[1] = { { x + 1.0f, y }, col, { 0.0f, 0.0f } };
+			vert[2] = { { x + 1.0f, y + 1.0f }, col, { 0.0f, 0.0f } };
+			vert[3] = { { x, y + 1.0f }, col, { 0.0f, 0.0f } };
+			index[0] = base;
+			index[1] = base + 1;
+			index[2] = base + 2;
+			index[3] = base;
+			index[4] = base + 2;
+			index[5] = base + 3;
+			vert += 4;
+			index += 6;
+			base += 4;
+		}
+		std::size_t drawn = static_cast<std::size_t>(base) / 4;
+		geometry(nullptr, Span<const SDL_Vertex>(lineVertices.data(), drawn * 4),
+			Span<const int>(lineIndices.data(), drawn * 6));
+	}
+
+	static void addPoint(float x, float y) {
+		Vec2 p = transform.apply(Vec2(x, y));
+		polyX.push_back(toPixel(p.x));
+		polyY.push_back(toPixel(p.y));
+	}
+
+	// the points along an elliptical arc, from `from` to `to` degrees
+	// clockwise, the way SDL2_gfx measures them
+	static void addArc(float x, float y, float rx, float ry, float from,
+		float to) {
+		float sweep = std::fmod(to - from, 360.0f);
+		if (sweep <= 0.0f)
+			sweep += 360.0f;
+		// a segment every few pixels of the transformed outline
+		float scale = std::sqrt(std::abs(transform.determinant()));
+		float length = std::max(rx, ry) * scale * sweep * RADIANS_PER_DEGREE;
+		int segments = std::clamp(static_cast<int>(length / 4.0f), 8, 256);
+		for (int i = 0; i <= segments; i++) {
+			float angle = (from + sweep * i / segments) * RADIANS_PER_DEGREE;
+			addPoint(x + std::cos(angle) * rx, y + std::sin(angle) * ry);
+		}
+	}
+
+	static void drawPoly(Color col, bool filled) {
+		int len = static_cast<int>(polyX.size());
+		if (filled)
+			filledPolygonRGBA(renderer, polyX.data(), polyY.data(), len,
+				col.r, col.g, col.b, col.a);
+		else
+			polygonRGBA(renderer, polyX.data(), polyY.data(), len,
+				col.r, col.g, col.b, col.a);
+		polyX.clear();
+		polyY.clear();
+	}
+
+	void frameStarted() {
+#ifdef DEBUG
+		const std::pair<std::uint32_t Stats::*, const char *> fields[] = {
+			{ &Stats::drawCalls, "draw calls" },
+			{ &Stats::gfxPrimitives, "gfx primitives" },
+			{ &Stats::textureCreations, "texture creations" },
+			{ &Stats::textureUploads, "texture uploads" },
+			{ &Stats::textRasterizations, "text rasterizations" },
+		};
+		bool over = false;
+		for (auto [field, name] : fields) {
+			if (budget.*field != 0 && stats.*field > budget.*field) {
+				log::error("Frame went over budget: %u %s, limit %u\n",
+					stats.*field, name, budget.*field);
+				over = true;
+			}
+		}
+		assert(!over && "graphics budget exceeded");
+#endif
+		stats = Stats();
+		transform = Mat3();
+		transformStack.clear();
+		transformChanged();
+		updateView();
+	}
+
+	Stats getStats() {
+		return stats;
+	}
+
+	void resetStats() {
+		stats = Stats();
+	}
+
+	Stats getStatsBudget() {
+		return budget;
+	}
+
+	void setStatsBudget(Stats newBudget) {
+		budget = newBudget;
+	}
+
 	void drawframe() {
+		ASTRUM_PROFILE_SCOPE("graphics::present");
 		const Color col = backgroundColor;
 		SDL_RenderPresent(renderer);
+		latency::framePresented();
 		SDL_SetRenderDrawColor(renderer, col.r, col.g, col.b, col.a);
 		SDL_RenderClear(renderer);
 	}
@@ -66,7 +381,8 @@ namespace graphics {
 		if (conf.existingWindow != nullptr)
 			renderer = SDL_GetRenderer(window::window);
 		if (renderer == nullptr)
-			renderer = SDL_CreateRenderer(window::window, -1, SDL_RENDERER_PRESENTVSYNC);
+			renderer = SDL_CreateRenderer(window::window, -1,
+				conf.unlimitedFrameRate ? 0 : SDL_RENDERER_PRESENTVSYNC);
 
 		// if renderer is still null, there's something wrong
 		if (renderer == nullptr)
@@ -76,10 +392,17 @@ namespace graphics {
 			SDL_RenderSetLogicalSize(renderer, conf.windowWidth, conf.windowHeight);
 			SDL_RenderSetIntegerScale(renderer, SDL_TRUE);
 		}
+
+		transform = Mat3();
+		transformStack.clear();
+		transformChanged();
+		scissor.reset();
+		updateView();
 	}
 
 	void QuitGraphics() {
 //		SDL_GL_DeleteContext(glcontext);
+		defaultFont = Font{ std::shared_ptr<FontData>() };
 		SDL_DestroyRenderer(renderer);
 	}
 
@@ -111,12 +434,25 @@ namespace graphics {
 		rectangle(x, y, width, height, currentColor, filled);
 	}
 	void rectangle(int x, int y, int width, int height, Color col, bool filled) {
+		if (culled(Rect(x, y, width, height)))
+			return;
+		countPrimitive();
+		if (!isAxisAligned()) {
+			addPoint(x, y);
+			addPoint(x + width, y);
+			addPoint(x + width, y + height);
+			addPoint(x, y + height);
+			drawPoly(col, filled);
+			return;
+		}
+		Vec2 p1 = transform.apply(Vec2(x, y));
+		Vec2 p2 = transform.apply(Vec2(x + width, y + height));
 		if (filled)
-			boxRGBA(renderer, x, y, x + width, y + height, col.r,
-				col.g, col.b, col.a);
+			boxRGBA(renderer, toPixel(p1.x), toPixel(p1.y), toPixel(p2.x),
+				toPixel(p2.y), col.r, col.g, col.b, col.a);
 		else
-			rectangleRGBA(renderer, x, y, x + width, y + height,
-				col.r, col.g, col.b, col.a);
+			rectangleRGBA(renderer, toPixel(p1.x), toPixel(p1.y),
+				toPixel(p2.x), toPixel(p2.y), col.r, col.g, col.b, col.a);
 	}
 
 	void rectangleFilled(int x, int y, int width, int height) {
@@ -130,12 +466,22 @@ namespace graphics {
 		circle(x, y, radius, currentColor, filled);
 	}
 	void circle(int x, int y, int radius, Color col, bool filled) {
+		if (transform.a != transform.d || transform.b != -transform.c) {
+			// no longer round
+			ellipse(x, y, radius, radius, col, filled);
+			return;
+		}
+		if (culled(Rect(x - radius, y - radius, radius * 2, radius * 2)))
+			return;
+		countPrimitive();
+		Vec2 center = transform.apply(Vec2(x, y));
+		int r = toPixel(radius * std::sqrt(std::abs(transform.determinant())));
 		if (filled)
-			filledCircleRGBA(renderer, x, y, radius, col.r, col.g,
-				col.b, col.a);
+			filledCircleRGBA(renderer, toPixel(center.x), toPixel(center.y),
+				r, col.r, col.g, col.b, col.a);
 		else
-			circleRGBA(renderer, x, y, radius, col.r, col.g, col.b,
-				col.a);
+			circleRGBA(renderer, toPixel(center.x), toPixel(center.y), r,
+				col.r, col.g, col.b, col.a);
 	}
 
 	void circleFilled(int x, int y, int radius) {
@@ -149,12 +495,21 @@ namespace graphics {
 		triangle(x1, y1, x2, y2, x3, y3, currentColor, filled);
 	}
 	void triangle(int x1, int y1, int x2, int y2, int x3, int y3, Color col, bool filled) {
+		const int coords[] = { x1, y1, x2, y2, x3, y3 };
+		if (culled(boundsOf(coords, 3)))
+			return;
+		countPrimitive();
+		Vec2 p1 = transform.apply(Vec2(x1, y1));
+		Vec2 p2 = transform.apply(Vec2(x2, y2));
+		Vec2 p3 = transform.apply(Vec2(x3, y3));
 		if (filled)
-			filledTrigonRGBA(renderer, x1, y1, x2, y2, x3, y3,
+			filledTrigonRGBA(renderer, toPixel(p1.x), toPixel(p1.y),
+				toPixel(p2.x), toPixel(p2.y), toPixel(p3.x), toPixel(p3.y),
 				col.r, col.g, col.b, col.a);
 		else
-			trigonRGBA(renderer, x1, y1, x2, y2, x3, y3, col.r,
-				col.g, col.b, col.a);
+			trigonRGBA(renderer, toPixel(p1.x), toPixel(p1.y),
+				toPixel(p2.x), toPixel(p2.y), toPixel(p3.x), toPixel(p3.y),
+				col.r, col.g, col.b, col.a);
 	}
 
 	void triangleFilled(int x1, int y1, int x2, int y2, int x3, int y3) {
@@ -168,12 +523,23 @@ namespace graphics {
 		ellipse(x, y, rx, ry, currentColor, filled);
 	}
 	void ellipse(int x, int y, int rx, int ry, Color col, bool filled) {
+		if (culled(Rect(x - rx, y - ry, rx * 2, ry * 2)))
+			return;
+		countPrimitive();
+		if (!isAxisAligned()) {
+			addArc(x, y, rx, ry, 0.0f, 360.0f);
+			drawPoly(col, filled);
+			return;
+		}
+		Vec2 center = transform.apply(Vec2(x, y));
+		int srx = toPixel(rx * std::abs(transform.a));
+		int sry = toPixel(ry * std::abs(transform.d));
 		if (filled)
-			filledEllipseRGBA(renderer, x, y, rx, ry, col.r, col.g,
-				col.b, col.a);
+			filledEllipseRGBA(renderer, toPixel(center.x), toPixel(center.y),
+				srx, sry, col.r, col.g, col.b, col.a);
 		else
-			ellipseRGBA(renderer, x, y, rx, ry, col.r, col.g, col.b,
-				col.a);
+			ellipseRGBA(renderer, toPixel(center.x), toPixel(center.y),
+				srx, sry, col.r, col.g, col.b, col.a);
 	}
 
 	void ellipseFilled(int x, int y, int rx, int ry) {
@@ -183,74 +549,212 @@ namespace graphics {
 		ellipse(x, y, rx, ry, col, true);
 	}
 
-	void polygon(const std::vector<int> vertices, bool filled) {
+	void polygon(const std::vector<int> &vertices, bool filled) {
 		polygon(vertices, currentColor, filled);
 	}
-	void polygon(const std::vector<int> vertices, Color col, bool filled) {
+	void polygon(const std::vector<int> &vertices, Color col, bool filled) {
 		assert((vertices.size() & 1) == 0);
 		size_t len = vertices.size() / 2;
-		short x[len];
-		short y[len];
-		for (size_t i = 0; i < len; i++) {
-			x[i] = vertices[i * 2];
-			y[i] = vertices[i * 2 + 1];
-		}
-		if (filled)
-			filledPolygonRGBA(renderer, x, y, len, col.r, col.g,
-				col.b, col.a);
-		else
-			polygonRGBA(renderer, x, y, len, col.r, col.g, col.b,
-				col.a);
+		if (len == 0 || culled(boundsOf(vertices.data(), len)))
+			return;
+		countPrimitive();
+		for (size_t i = 0; i < len; i++)
+			addPoint(vertices[i * 2], vertices[i * 2 + 1]);
+		drawPoly(col, filled);
 	}
 
-	void polygonFilled(const std::vector<int> vertices) {
+	void polygonFilled(const std::vector<int> &vertices) {
 		polygon(vertices, currentColor, true);
 	}
-	void polygonFilled(const std::vector<int> vertices, Color col) {
+	void polygonFilled(const std::vector<int> &vertices, Color col) {
 		polygon(vertices, col, true);
 	}
 
+	void polygon(Span<const Vec2> points, bool filled) {
+		polygon(points, currentColor, filled);
+	}
+	void polygon(Span<const Vec2> points, Color col, bool filled) {
+		if (points.size() < 2 || culled(boundsOf(points)))
+			return;
+		if (filled) {
+			countPrimitive();
+			for (Vec2 p : points)
+				addPoint(p.x, p.y);
+			drawPoly(col, true);
+			return;
+		}
+		for (Vec2 p : points)
+			addLinePoint(p);
+		addLinePoint(points[0]);
+		drawLineStrip(col);
+	}
+
+	void polyline(Span<const Vec2> points) {
+		polyline(points, currentColor);
+	}
+	void polyline(Span<const Vec2> points, Color col) {
+		if (points.size() < 2 || culled(boundsOf(points)))
+			return;
+		for (Vec2 p : points)
+			addLinePoint(p);
+		drawLineStrip(col);
+	}
+
 	void point(int x, int y) {
 		point(x, y, currentColor);
 	}
 	void point(int x, int y, Color col) {
-		pixelRGBA(renderer, x, y, col.r, col.g, col.b, col.a);
+		if (culled(Rect(x, y, 0.0f, 0.0f)))
+			return;
+		countPrimitive();
+		Vec2 p = transform.apply(Vec2(x, y));
+		pixelRGBA(renderer, toPixel(p.x), toPixel(p.y), col.r, col.g, col.b,
+			col.a);
+	}
+
+	void points(Span<const Vec2> points) {
+		graphics::points(points, currentColor);
+	}
+	void points(Span<const Vec2> points, Color col) {
+		ASTRUM_PROFILE_SCOPE("graphics::points");
+		for (Vec2 point : points) {
+			SDL_FPoint p;
+			if (toScreen(point, p))
+				screenPoints.push_back(p);
+		}
+		if (screenPoints.empty()) {
+			if (!points.empty())
+				stats.culled++;
+			return;
+		}
+		setDrawColor(col);
+		SDL_RenderDrawPointsF(renderer, screenPoints.data(),
+			static_cast<int>(screenPoints.size()));
+		stats.drawCalls++;
+		screenPoints.clear();
+	}
+	void points(Span<const Point> points) {
+		ASTRUM_PROFILE_SCOPE("graphics::points");
+		std::size_t groups = 0;
+		bool tooManyColors = false;
+		std::uint32_t keys[MAX_POINT_GROUPS];
+		// colours hashed to their groups, since random colours would make
+		// any search mispredict
+		constexpr std::uint8_t EMPTY = 0xFF;
+		std::uint8_t slots[256];
+		std::fill(std::begin(slots), std::end(slots), EMPTY);
+		for (const Point &point : points) {
+			SDL_FPoint p;
+			if (!toScreen(point.position, p))
+				continue;
+			std::uint32_t key = packColor(point.color);
+			std::size_t slot = (key * 0x9E3779B1u) >> 24;
+			while (slots[slot] != EMPTY && keys[slots[slot]] != key)
+				slot = (slot + 1) & 0xFF;
+			if (slots[slot] == EMPTY) {
+				if (groups == MAX_POINT_GROUPS) {
+					tooManyColors = true;
+					break;
+				}
+				if (pointGroups.size() == groups)
+					pointGroups.emplace_back();
+				pointGroups[groups].color = point.color;
+				keys[groups] = key;
+				slots[slot] = static_cast<std::uint8_t>(groups++);
+			}
+			pointGroups[slots[slot]].points.push_back(p);
+		}
+
+		for (std::size_t i = 0; i < groups; i++) {
+			PointGroup &group = pointGroups[i];
+			if (!tooManyColors) {
+				setDrawColor(group.color);
+				SDL_RenderDrawPointsF(renderer, group.points.data(),
+					static_cast<int>(group.points.size()));
+				stats.drawCalls++;
+			}
+			group.points.clear();
+		}
+		if (tooManyColors)
+			drawPointQuads(points);
+		else if (groups == 0 && !points.empty())
+			stats.culled++;
 	}
 
 	void line(int x1, int y1, int x2, int y2) {
 		line(x1, y1, x2, y2, currentColor);
 	}
 	void line(int x1, int y1, int x2, int y2, Color col) {
+		const int coords[] = { x1, y1, x2, y2 };
+		if (culled(boundsOf(coords, 2)))
+			return;
+		countPrimitive();
+		Vec2 p1 = transform.apply(Vec2(x1, y1));
+		Vec2 p2 = transform.apply(Vec2(x2, y2));
 		if (lineThickness > 1)
-			thickLineRGBA(renderer, x1, y1, x2, y2, lineThickness,
+			thickLineRGBA(renderer, toPixel(p1.x), toPixel(p1.y),
+				toPixel(p2.x), toPixel(p2.y), lineThickness,
 				col.r, col.g, col.b, col.a);
 		else
-			lineRGBA(renderer, x1, y1, x2, y2, col.r, col.g, col.b,
-				col.a);
+			lineRGBA(renderer, toPixel(p1.x), toPixel(p1.y), toPixel(p2.x),
+				toPixel(p2.y), col.r, col.g, col.b, col.a);
 	}
-	void line(const std::vector<int> lines) {
-		assert((lines.size() & 3) == 0);
-		for (size_t i = 0; i < lines.size(); i += 4)
-			line(lines[i], lines[i + 1], lines[i + 2], lines[i + 3],
-				currentColor);
+	void line(const std::vector<int> &lines) {
+		line(lines, currentColor);
 	}
-	void line(const std::vector<int> lines, Color col) {
+	void line(const std::vector<int> &lines, Color col) {
 		assert((lines.size() & 3) == 0);
-		for (size_t i = 0; i < lines.size(); i += 4)
-			line(lines[i], lines[i + 1], lines[i + 2], lines[i + 3],
-				col);
+		if (lines.empty() || culled(boundsOf(lines.data(), lines.size() / 2)))
+			return;
+		for (size_t i = 0; i + 3 < lines.size(); i += 4) {
+			addLinePoint(Vec2(lines[i], lines[i + 1]));
+			addLinePoint(Vec2(lines[i + 2], lines[i + 3]));
+		}
+		if (lineThickness > 1) {
+			drawThickLines(false, col);
+			return;
+		}
+		// SDL2 has no call for separate lines, but one colour change
+		// still beats a SDL2_gfx call per line
+		setDrawColor(col);
+		for (size_t i = 0; i < screenPoints.size(); i += 2) {
+			SDL_RenderDrawLinesF(renderer, &screenPoints[i], 2);
+			stats.drawCalls++;
+		}
+		screenPoints.clear();
 	}
 
 	void arc(int x, int y, int r, int a1, int a2, bool filled) {
 		arc(x, y, r, a1, a2, currentColor, filled);
 	}
 	void arc(int x, int y, int r, int a1, int a2, Color col, bool filled) {
+		if (culled(Rect(x - r, y - r, r * 2, r * 2)))
+			return;
+		countPrimitive();
+		if (isAxisAligned() && transform.a == transform.d && transform.a > 0.0f) {
+			Vec2 center = transform.apply(Vec2(x, y));
+			int sr = toPixel(r * transform.a);
+			if (filled)
+				filledPieRGBA(renderer, toPixel(center.x), toPixel(center.y),
+					sr, a1, a2, col.r, col.g, col.b, col.a);
+			else
+				arcRGBA(renderer, toPixel(center.x), toPixel(center.y), sr,
+					a1, a2, col.r, col.g, col.b, col.a);
+			return;
+		}
+		// flipped or stretched, so the angles no longer line up
 		if (filled)
-			filledPieRGBA(renderer, x, y, r, a1, a2, col.r, col.g,
-				col.b, col.a);
-		else
-			arcRGBA(renderer, x, y, r, a1, a2, col.r, col.g, col.b,
-				col.a);
+			addPoint(x, y);
+		addArc(x, y, r, r, a1, a2);
+		if (filled) {
+			drawPoly(col, true);
+			return;
+		}
+		for (std::size_t i = 1; i < polyX.size(); i++)
+			lineRGBA(renderer, polyX[i - 1], polyY[i - 1], polyX[i], polyY[i],
+				col.r, col.g, col.b, col.a);
+		polyX.clear();
+		polyY.clear();
 	}
 
 	void arcFilled(int x, int y, int r, int a1, int a2) {
@@ -270,16 +774,29 @@ namespace graphics {
 		SDL_RenderClear(renderer);
 	}
 
-	void print(std::string str, int x, int y) {
+	void print(const char *str, int x, int y) {
 		print(str, x, y, defaultFont, currentColor);
 	}
-	void print(std::string str, int x, int y, Font font) {
+	void print(const char *str, int x, int y, Font font) {
 		print(str, x, y, font, currentColor);
 	}
-	void print(std::string str, int x, int y, Color col) {
+	void print(const char *str, int x, int y, Color col) {
 		print(str, x, y, defaultFont, col);
 	}
-	void print(std::string str, int x, int y, Font font, Color col) {
+	void print(const std::string &str, int x, int y) {
+		print(str.c_str(), x, y, defaultFont, currentColor);
+	}
+	void print(const std::string &str, int x, int y, Font font) {
+		print(str.c_str(), x, y, font, currentColor);
+	}
+	void print(const std::string &str, int x, int y, Color col) {
+		print(str.c_str(), x, y, defaultFont, col);
+	}
+	void print(const std::string &str, int x, int y, Font font, Color col) {
+		print(str.c_str(), x, y, font, col);
+	}
+	void print(const char *str, int x, int y, Font font, Color col) {
+		ASTRUM_PROFILE_SCOPE("graphics::print");
 		Image image = font.renderText(str, col);
 
 		TextAlign align = font.getAlign();
@@ -303,25 +820,233 @@ namespace graphics {
 	}
 
 	void render(Image image, int x, int y) {
+		ASTRUM_PROFILE_SCOPE("graphics::render");
 		Transforms tran = image.getTransforms();
 		std::shared_ptr<ImageData> data = image.getData();
 		SDL_Surface *surf = data->image;
+		int width = static_cast<int>(surf->w * tran.sx);
+		int height = static_cast<int>(surf->h * tran.sy);
+		// turned and sheared about its centre, as SDL_RenderCopyEx turns it
+		Vec2 center(x + width / 2.0f, y + height / 2.0f);
+		Mat3 local = Mat3::translation(center.x, center.y)
+			* Mat3::rotation(static_cast<float>(tran.degrees) * RADIANS_PER_DEGREE)
+			* Mat3::shearing(static_cast<float>(tran.kx),
+				static_cast<float>(tran.ky))
+			* Mat3::translation(-center.x, -center.y);
+		if (culled(local.applyRect(Rect(x, y, width, height))))
+			return;
+		// the offset source is clipped to the surface, and what is left is
+		// stretched over the whole image, as SDL_RenderCopyEx does
+		int left = std::clamp(tran.dx, 0, surf->w);
+		int top = std::clamp(tran.dy, 0, surf->h);
+		int right = std::clamp(tran.dx + surf->w, 0, surf->w);
+		int bottom = std::clamp(tran.dy + surf->h, 0, surf->h);
+		if (left >= right || top >= bottom)
+			return;
+
 		SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surf);
+		stats.textureCreations++;
+		stats.textureUploads++;
+
+		// SDL_RenderCopyEx can't shear
+		if (translateOnly && tran.kx == 0.0 && tran.ky == 0.0) {
+			SDL_Rect sourceRect = { .x = left, .y = top, .w = right - left,
+				.h = bottom - top };
+			SDL_Rect renderRect = { .x = x + toPixel(transform.tx),
+				.y = y + toPixel(transform.ty), .w = width, .h = height };
+			SDL_RendererFlip flip = SDL_FLIP_NONE;
+			double degrees = tran.degrees;
 
-		// TODO apply shear `kx, ky`
-		SDL_Rect sourceRect = { .x = tran.dx, .y = tran.dy,
-			.w = surf->w, .h = surf->h };
-		SDL_Rect renderRect = { .x = x, .y = y,
-			.w = static_cast<int>(surf->w * tran.sx),
-			.h = static_cast<int>(surf->h * tran.sy) };
-		SDL_RendererFlip flip = SDL_FLIP_NONE;
-		double degrees = tran.degrees;
-
-		SDL_RenderCopyEx(renderer, tex, &sourceRect, &renderRect,
-			degrees, nullptr, flip);
+			SDL_RenderCopyEx(renderer, tex, &sourceRect, &renderRect,
+				degrees, nullptr, flip);
+			stats.drawCalls++;
+		} else {
+			// SDL_RenderGeometry only takes texture coordinates in [0, 1]
+			float texW = static_cast<float>(surf->w);
+			float texH = static_cast<float>(surf->h);
+			Rect uv(left / texW, top / texH, (right - left) / texW,
+				(bottom - top) / texH);
+			if (!drawQuad(tex, transform * local, Rect(x, y, width, height), uv,
+				Color(0xFF, 0xFF, 0xFF, 0xFF)))
+				log::error("Could not render image: %s\n", SDL_GetError());
+		}
 		SDL_DestroyTexture(tex);
 	}
 
+	Mat3 DrawParams::getTransform() const {
+		return Mat3::translation(this->position.x, this->position.y)
+			* Mat3::rotation(this->rotation)
+			* Mat3::scaling(this->scale.x, this->scale.y)
+			* Mat3::shearing(this->shear.x, this->shear.y)
+			* Mat3::translation(-this->origin.x, -this->origin.y);
+	}
+
+	void draw(Image image, const DrawParams &params) {
+		ASTRUM_PROFILE_SCOPE("graphics::draw");
+		ImageData &data = *image.getData();
+		if (data.image == nullptr)
+			return;
+		SDL_Texture *texture = getTexture(data);
+		if (texture != nullptr)
+			drawTexture(texture, data.image->w, data.image->h, params);
+	}
+
+	void draw(Image image, float x, float y) {
+		draw(image, DrawParams(x, y));
+	}
+
+	void drawTexture(SDL_Texture *texture, int width, int height,
+		const DrawParams &params) {
+		float texW = static_cast<float>(width);
+		float texH = static_cast<float>(height);
+		Rect source = params.source.value_or(Rect(0.0f, 0.0f, texW, texH));
+		// SDL_RenderGeometry only takes texture coordinates in [0, 1], so
+		// the part of the source outside the texture is left out, and the
+		// quad shrinks with it
+		float left = std::clamp(source.left(), 0.0f, texW);
+		float top = std::clamp(source.top(), 0.0f, texH);
+		float right = std::clamp(source.right(), 0.0f, texW);
+		float bottom = std::clamp(source.bottom(), 0.0f, texH);
+		if (left >= right || top >= bottom)
+			return;
+		Rect quad(left - source.x, top - source.y, right - left, bottom - top);
+		// mirrored within the whole source, not just the part left
+		if (params.flipX)
+			quad.x = source.w - quad.right();
+		if (params.flipY)
+			quad.y = source.h - quad.bottom();
+		Mat3 m = transform * params.getTransform();
+		if (cull(m.applyRect(quad)))
+			return;
+
+		Rect uv(left / texW, top / texH, (right - left) / texW,
+			(bottom - top) / texH);
+		// mirrored in place by swapping texture coordinates
+		if (params.flipX)
+			uv = Rect(uv.right(), uv.top(), -uv.w, uv.h);
+		if (params.flipY)
+			uv = Rect(uv.left(), uv.bottom(), uv.w, -uv.h);
+		if (!drawQuad(texture, m, quad, uv, params.tint))
+			log::error("Could not draw texture: %s\n", SDL_GetError());
+	}
+
+	SDL_Renderer *getRenderer() {
+		return renderer;
+	}
+
+	SDL_Texture *getTexture(ImageData &data) {
+		// one texture for every image sharing the surface
+		if (data.shared != nullptr)
+			return getTexture(*data.shared);
+		if (data.texture != nullptr || data.image == nullptr)
+			return data.texture;
+		data.texture = SDL_CreateTextureFromSurface(renderer, data.image);
+		if (data.texture == nullptr) {
+			log::error("Could not create texture: %s\n", SDL_GetError());
+			return nullptr;
+		}
+		stats.textureCreations++;
+		stats.textureUploads++;
+		// the renderer's copy, assuming 4 bytes a pixel
+		resources::track(data.texture, ResourceType::texture,
+			static_cast<std::size_t>(data.image->w) * data.image->h * 4);
+		return data.texture;
+	}
+
+	bool geometry(SDL_Texture *texture, Span<const SDL_Vertex> vertices,
+		Span<const int> indices) {
+		if (vertices.empty())
+			return true;
+		// untextured geometry blends with the draw blend mode, which SDL2_gfx
+		// leaves off after opaque draws
+		if (texture == nullptr)
+			SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		int result = SDL_RenderGeometry(renderer, texture, vertices.data(),
+			static_cast<int>(vertices.size()),
+			indices.empty() ? nullptr : indices.data(),
+			static_cast<int>(indices.size()));
+		stats.drawCalls++;
+		return result == 0;
+	}
+
+	Rect getViewBounds() {
+		return view;
+	}
+
+	void push() {
+		transformStack.push_back(transform);
+	}
+
+	void pop() {
+		if (transformStack.empty()) {
+			log::warn("graphics::pop without a matching push\n");
+			return;
+		}
+		transform = transformStack.back();
+		transformStack.pop_back();
+		transformChanged();
+	}
+
+	void origin() {
+		setTransform(Mat3());
+	}
+
+	void translate(float dx, float dy) {
+		applyTransform(Mat3::translation(dx, dy));
+	}
+
+	void scale(float sx, float sy) {
+		applyTransform(Mat3::scaling(sx, sy));
+	}
+
+	void rotate(float radians) {
+		applyTransform(Mat3::rotation(radians));
+	}
+
+	void shear(float kx, float ky) {
+		applyTransform(Mat3::shearing(kx, ky));
+	}
+
+	void applyTransform(const Mat3 &other) {
+		transform *= other;
+		transformChanged();
+	}
+
+	Mat3 getTransform() {
+		return transform;
+	}
+
+	void setTransform(const Mat3 &other) {
+		transform = other;
+		transformChanged();
+	}
+
+	Vec2 transformPoint(Vec2 point) {
+		return transform.apply(point);
+	}
+
+	Vec2 inverseTransformPoint(Vec2 point) {
+		return transform.inverse().apply(point);
+	}
+
+	void setScissor(const Rect &rect) {
+		SDL_Rect clip = { toPixel(rect.x), toPixel(rect.y), toPixel(rect.w),
+			toPixel(rect.h) };
+		SDL_RenderSetClipRect(renderer, &clip);
+		scissor = rect;
+		updateView();
+	}
+
+	void setScissor() {
+		SDL_RenderSetClipRect(renderer, nullptr);
+		scissor.reset();
+		updateView();
+	}
+
+	std::optional<Rect> getScissor() {
+		return scissor;
+	}
+
 	std::tuple<int, int> getVirtualCoords(int x, int y) {
 		float logicalX, logicalY;
 		SDL_RenderWindowToLogical(renderer, x, y, &logicalX, &logicalY);
@@ -342,4 +1067,29 @@ namespace graphics {
 	}
 };
 
+Mat3 Camera::getTransform() const {
+	Vec2 center = graphics::screen.center();
+	return Mat3::translation(center.x, center.y)
+		* Mat3::scaling(this->zoom, this->zoom)
+		* Mat3::rotation(-this->rotation)
+		* Mat3::translation(-this->position.x, -this->position.y);
+}
+
+void Camera::attach() const {
+	graphics::push();
+	graphics::applyTransform(this->getTransform());
+}
+
+void Camera::detach() const {
+	graphics::pop();
+}
+
+Vec2 Camera::toScreen(Vec2 world) const {
+	return this->getTransform().apply(world);
+}
+
+Vec2 Camera::toWorld(Vec2 screen) const {
+	return this->getTransform().inverse().apply(screen);
+}
+
 }; // namespace Astrum
@@ -8,6 +8,7 @@
 #include "internals.hpp"
 #include "astrum/constants.hpp"
 #include "astrum/image.hpp"
+#include "astrum/profile.hpp"
 
 namespace Astrum {
 
@@ -15,15 +16,27 @@ Image::Image(std::shared_ptr<ImageData> data) {
 	this->data = data;
 }
 Image::Image(std::string filename) {
-	SDL_Surface *surf = IMG_Load(filename.c_str());
-	if (surf == nullptr)
-		throw std::runtime_error("Failed to create image");
-	SDL_SetSurfaceRLE(surf, 1);
-	this->data = std::make_shared<ImageData>(surf);
+	std::string key = resources::imageKey(filename);
+	auto loaded = std::static_pointer_cast<ImageData>(
+		resources::findCached(key));
+	if (loaded == nullptr) {
+		ASTRUM_PROFILE_SCOPE("Image load");
+		SDL_Surface *surf = IMG_Load(filename.c_str());
+		if (surf == nullptr)
+			throw std::runtime_error("Failed to create image");
+		SDL_SetSurfaceRLE(surf, 1);
+		loaded = std::make_shared<ImageData>(surf);
+		resources::describe(loaded.get(), filename);
+		loaded = std::static_pointer_cast<ImageData>(
+			resources::cache(key, loaded));
+	}
+	// the pixels are shared, the transforms are not
+	this->data = std::make_shared<ImageData>(loaded);
 }
 Image::Image(std::filesystem::path filename)
 	: Image(filename.string()) { };
 Image::Image(const unsigned char *buf, std::size_t bufLen, std::string type) {
+	ASTRUM_PROFILE_SCOPE("Image load");
 	SDL_RWops *rw = SDL_RWFromConstMem(buf, bufLen);
 	if (rw == nullptr)
 		throw std::runtime_error("Failed to create image");
@@ -7,7 +7,10 @@
 #	define UNUSED(x) UNUSED_##x
 #endif
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <utility>
 #include <functional>
@@ -15,39 +18,79 @@
 #include "sdl.hpp"
 #include "astrum/constants.hpp"
 #include "astrum/font.hpp"
+#include "astrum/graphics.hpp"
 #include "astrum/key.hpp"
 #include "astrum/image.hpp"
 #include "astrum/mouse.hpp"
+#include "astrum/resources.hpp"
+#include "astrum/util.hpp"
 
 namespace Astrum {
 
 extern bool hasInit;
 extern std::vector<std::pair<void *, std::function<void(void *)>>> dropQueue;
 
+// declared ahead of the resource structs, which register themselves
+namespace resources {
+	// keyed by the owning object, usually the struct holding the resource
+	void track(const void *key, ResourceType type, std::size_t bytes);
+	void describe(const void *key, const std::string &name);
+	// for move construction and assignment, replacing whatever `to` held
+	void moved(const void *from, const void *to);
+	void untrack(const void *key);
+
+	// the cache of resources loaded from files, keyed by `imageKey` or
+	// `fontKey`; `findCached` is null when nothing live has that key. It
+	// holds the data that owns the surface or font, which each loaded
+	// `Image` or `Font` shares through data of its own
+	std::string imageKey(const std::string &path);
+	std::string fontKey(const std::string &path, int size, int style);
+	std::shared_ptr<void> findCached(const std::string &key);
+	// returns what is cached under the key afterwards, which is what
+	// another thread loaded first if the two raced
+	std::shared_ptr<void> cache(const std::string &key,
+		std::shared_ptr<void> data);
+};
+
 struct FontData {
 	TTF_Font *font = nullptr;
 	Color defaultColor;
 	TextAlign defaultAlign;
+	// set for a font loaded from the cache: the font belongs to `shared`,
+	// and only the colour and alignment are this font's own
+	std::shared_ptr<FontData> shared;
 	FontData(TTF_Font *font, Color defaultColor, TextAlign defaultAlign)
 		: font(font), defaultColor(defaultColor),
-		defaultAlign(defaultAlign) { }
+		defaultAlign(defaultAlign) {
+		if (font != nullptr)
+			resources::track(this, ResourceType::font, 0);
+	}
+	FontData(std::shared_ptr<FontData> shared, Color defaultColor,
+		TextAlign defaultAlign) : font(shared->font),
+		defaultColor(defaultColor), defaultAlign(defaultAlign),
+		shared(std::move(shared)) { }
 	FontData(const FontData &src) = delete;
 	FontData(FontData &&src) : font(src.font),
-		defaultColor(src.defaultColor), defaultAlign(src.defaultAlign) {
+		defaultColor(src.defaultColor), defaultAlign(src.defaultAlign),
+		shared(std::move(src.shared)) {
 		src.font = nullptr;
+		resources::moved(&src, this);
 	}
 	FontData &operator=(const FontData &src) = delete;
 	FontData &operator=(FontData &&src) {
 		this->font = src.font;
 		this->defaultColor = src.defaultColor;
 		this->defaultAlign = src.defaultAlign;
+		this->shared = std::move(src.shared);
 		src.font = nullptr;
+		resources::moved(&src, this);
 		return *this;
 	}
 	~FontData() {
-		if (this->font == nullptr) {
+		if (this->font == nullptr || this->shared != nullptr)
 			return;
-		} else if (hasInit) {
+		resources::untrack(this);
+		if (hasInit) {
 			TTF_CloseFont(this->font);
 		} else {
 			auto pair = std::make_pair((void *) this->font, (void (*)(void *)) TTF_CloseFont);
@@ -58,23 +101,51 @@ struct FontData {
 
 struct ImageData {
 	SDL_Surface *image = nullptr;
+	// uploaded on first use by `graphics::getTexture`, for draws that
+	// happen every frame
+	SDL_Texture *texture = nullptr;
 	Transforms tran;
-	ImageData(SDL_Surface *surf) : image(surf) { }
+	// set for an image loaded from the cache: the surface and texture
+	// belong to `shared`, and only the transforms are this image's own
+	std::shared_ptr<ImageData> shared;
+	ImageData(SDL_Surface *surf) : image(surf) {
+		if (surf != nullptr)
+			resources::track(this, ResourceType::image,
+				static_cast<std::size_t>(surf->pitch) * surf->h);
+	}
+	ImageData(std::shared_ptr<ImageData> shared) : image(shared->image),
+		shared(std::move(shared)) { }
 	ImageData(const ImageData &src) = delete;
-	ImageData(ImageData &&src) : image(src.image), tran(src.tran) {
+	ImageData(ImageData &&src) : image(src.image), texture(src.texture),
+		tran(src.tran), shared(std::move(src.shared)) {
 		src.image = nullptr;
+		src.texture = nullptr;
+		resources::moved(&src, this);
 	}
 	ImageData &operator=(const ImageData &src) = delete;
 	ImageData &operator=(ImageData &&src) {
 		this->image = src.image;
+		this->texture = src.texture;
 		this->tran = src.tran;
+		this->shared = std::move(src.shared);
 		src.image = nullptr;
+		src.texture = nullptr;
+		resources::moved(&src, this);
 		return *this;
 	}
 	~ImageData() {
-		if (this->image == nullptr) {
+		if (this->shared != nullptr)
+			return;
+		if (this->texture != nullptr) {
+			resources::untrack(this->texture);
+			// otherwise it went with the renderer
+			if (hasInit)
+				SDL_DestroyTexture(this->texture);
+		}
+		if (this->image == nullptr)
 			return;
-		} else if (hasInit) {
+		resources::untrack(this);
+		if (hasInit) {
 			SDL_FreeSurface(this->image);
 		} else {
 			auto pair = std::make_pair((void *) this->image, (void (*)(void *)) SDL_FreeSurface);
@@ -88,22 +159,29 @@ struct CursorData {
 	// used for system cursors, which don't have manual memory management
 	bool nofree;
 	CursorData(SDL_Cursor *cursor, bool nofree = false) : cursor(cursor),
-		nofree(nofree) { }
+		nofree(nofree) {
+		// borrowed cursors are owned, and counted, elsewhere
+		if (cursor != nullptr && !nofree)
+			resources::track(this, ResourceType::cursor, 0);
+	}
 	CursorData(const CursorData &src) = delete;
 	CursorData(CursorData &&src) : cursor(src.cursor), nofree(src.nofree) {
 		src.cursor = nullptr;
+		resources::moved(&src, this);
 	}
 	CursorData &operator=(const CursorData &src) = delete;
 	CursorData &operator=(CursorData &&src) {
 		this->cursor = src.cursor;
 		this->nofree = src.nofree;
 		src.cursor = nullptr;
+		resources::moved(&src, this);
 		return *this;
 	}
 	~CursorData() {
-		if (this->cursor == nullptr || this->nofree) {
+		if (this->cursor == nullptr || this->nofree)
 			return;
-		} else if (hasInit) {
+		resources::untrack(this);
+		if (hasInit) {
 			SDL_FreeCursor(this->cursor);
 		} else {
 			auto pair = std::make_pair((void *) this->cursor, (void (*)(void *)) SDL_FreeCursor);
@@ -115,20 +193,26 @@ struct CursorData {
 struct SoundData {
 	Mix_Chunk *chunk = nullptr;
 	std::vector<int> channels;
-	SoundData(Mix_Chunk *chunk) : chunk(chunk) { }
+	SoundData(Mix_Chunk *chunk) : chunk(chunk) {
+		// the decoded samples
+		if (chunk != nullptr)
+			resources::track(this, ResourceType::sound, chunk->alen);
+	}
 	SoundData(const SoundData &src) = delete;
 	SoundData(SoundData &&src) : chunk(src.chunk), channels(src.channels) {
 		src.chunk = nullptr;
 		src.channels.clear();
+		resources::moved(&src, this);
 	}
 	~SoundData() {
 		// TODO should error when still playing?
 		// it's unlikely the user ever intends to end a sound playing
 		//	by releasing the sound resource instead of ending
 		//	playback normally
-		if (this->chunk == nullptr) {
+		if (this->chunk == nullptr)
 			return;
-		} else if (hasInit) {
+		resources::untrack(this);
+		if (hasInit) {
 			Mix_FreeChunk(this->chunk);
 		} else {
 			auto pair = std::make_pair((void *) this->chunk, (void (*)(void *)) Mix_FreeChunk);
@@ -145,13 +229,35 @@ namespace window {
 };
 namespace mouse {
 	void InitMouse();
+	void QuitMouse();
 	void addMousedown(MouseButton btn);
 	void removeMousedown(MouseButton btn);
+	void addMotion(const SDL_Event &e);
+	void flushMotion();
 };
 namespace graphics {
+	// incremented wherever the work happens
+	extern Stats stats;
+
 	void InitGraphics(const Config &conf);
+	// checks the budget, then resets the counters
+	void frameStarted();
 	void QuitGraphics();
 	void drawframe();
+	SDL_Renderer *getRenderer();
+	// the screen, less what the scissor rect cuts off
+	Rect getViewBounds();
+	// whether `bounds`, on screen, misses the view, counting the draw as
+	// culled if so
+	bool cull(const Rect &bounds);
+	// the image's texture, uploaded on the first call
+	SDL_Texture *getTexture(ImageData &data);
+	// `graphics::draw` for any texture, `width` by `height` pixels
+	void drawTexture(SDL_Texture *texture, int width, int height,
+		const DrawParams &params);
+	// one SDL_RenderGeometry call; `indices` may be empty
+	bool geometry(SDL_Texture *texture, Span<const SDL_Vertex> vertices,
+		Span<const int> indices);
 };
 namespace keyboard {
 	void addKeydown(Key key);
@@ -163,9 +269,44 @@ namespace filesystem {
 };
 namespace timer {
 	void InitTimer();
+	void setDelta(double delta);
 };
 namespace math {
 	void InitMath();
+	unsigned getSeed();
+};
+namespace gamepad {
+	void QuitGamepad();
+	void handleGamepadEvent(const SDL_Event &e);
+	void handleJoystickEvent(const SDL_Event &e);
+	void refresh();
+};
+namespace telemetry {
+	enum class Phase { events, update, draw, present };
+	void QuitTelemetry();
+	void frameStarted();
+	// adds the time since the previous call to `phase`
+	void phaseDone(Phase phase);
+	void eventsHandled(std::uint32_t count);
+};
+namespace latency {
+	void stamp(const SDL_Event &e);
+	void frameDrawn();
+	void framePresented();
+};
+namespace replay {
+	void InitReplay(const Config &conf);
+	void QuitReplay();
+	void recordFrame(double dt);
+	void recordEvent(const SDL_Event &e);
+	bool nextFrame(double realDt, double &dt);
+	bool pollEvent(SDL_Event *e);
+	// the state a gamepad was added with, which a replay can't query
+	void recordGamepad(SDL_JoystickID id, const float *axes,
+		std::size_t count, std::uint32_t buttons);
+	bool nextGamepad(SDL_JoystickID id, float *axes, std::size_t count,
+		std::uint32_t &buttons);
+	unsigned filterSeed(unsigned seed);
 };
 
 static constexpr MouseButton fromMouseBtn(int button) {
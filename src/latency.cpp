@@ -0,0 +1,140 @@
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <string>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/latency.hpp"
+#include "astrum/graphics.hpp"
+#include "astrum/util.hpp"
+
+namespace Astrum {
+
+namespace latency {
+
+	namespace {
+		// events handled per frame beyond this aren't sampled
+		constexpr std::size_t MAX_PER_FRAME = 64;
+		constexpr std::size_t BUCKETS = LatencyStats::BUCKET_COUNT;
+
+		// handled but not drawn yet
+		Uint32 pendingStamps[MAX_PER_FRAME];
+		std::size_t pendingCount = 0;
+		// drawn but not presented yet
+		Uint32 drawnStamps[MAX_PER_FRAME];
+		std::size_t drawnCount = 0;
+
+		std::uint32_t ring[WINDOW];
+		std::size_t ringPos = 0;
+		std::size_t ringCount = 0;
+		std::uint32_t buckets[BUCKETS] = { };
+	};
+
+	void stamp(const SDL_Event &e) {
+		switch (e.type) {
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+		case SDL_MOUSEMOTION:
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEWHEEL:
+		case SDL_CONTROLLERAXISMOTION:
+		case SDL_CONTROLLERBUTTONDOWN:
+		case SDL_CONTROLLERBUTTONUP:
+			if (pendingCount < MAX_PER_FRAME)
+				pendingStamps[pendingCount++] = e.common.timestamp;
+			break;
+		}
+	}
+
+	void frameDrawn() {
+		std::size_t count = std::min(pendingCount, MAX_PER_FRAME - drawnCount);
+		std::copy_n(pendingStamps, count, drawnStamps + drawnCount);
+		drawnCount += count;
+		pendingCount = 0;
+	}
+
+	static void addSample(std::uint32_t ms) {
+		if (ringCount == WINDOW) {
+			std::uint32_t old = ring[ringPos];
+			buckets[std::min<std::size_t>(old, BUCKETS - 1)]--;
+		} else {
+			ringCount++;
+		}
+		ring[ringPos] = ms;
+		ringPos = (ringPos + 1) % WINDOW;
+		buckets[std::min<std::size_t>(ms, BUCKETS - 1)]++;
+	}
+
+	void framePresented() {
+		Uint32 now = SDL_GetTicks();
+		for (std::size_t i = 0; i < drawnCount; i++)
+			addSample(now - drawnStamps[i]);
+		drawnCount = 0;
+	}
+
+	static double percentile(double fraction) {
+		std::size_t target = static_cast<std::size_t>(fraction * ringCount);
+		std::size_t seen = 0;
+		for (std::size_t i = 0; i < BUCKETS; i++) {
+			seen += buckets[i];
+			if (seen > target)
+				return i;
+		}
+		return BUCKETS - 1;
+	}
+
+	LatencyStats getStats() {
+		LatencyStats stats;
+		stats.samples = ringCount;
+		if (ringCount == 0)
+			return stats;
+		std::uint32_t lo = ring[0], hi = ring[0];
+		double total = 0.0;
+		for (std::size_t i = 0; i < ringCount; i++) {
+			lo = std::min(lo, ring[i]);
+			hi = std::max(hi, ring[i]);
+			total += ring[i];
+		}
+		stats.min = lo;
+		stats.max = hi;
+		stats.mean = total / ringCount;
+		stats.p50 = percentile(0.50);
+		stats.p95 = percentile(0.95);
+		stats.p99 = percentile(0.99);
+		std::copy_n(buckets, BUCKETS, stats.buckets.begin());
+		return stats;
+	}
+
+	void reset() {
+		ringPos = ringCount = 0;
+		std::fill_n(buckets, BUCKETS, 0);
+	}
+
+	void drawOverlay(int x, int y) {
+		const int barWidth = 2;
+		const int graphHeight = 40;
+		LatencyStats stats = getStats();
+		std::string text = util::strformat(
+			"input latency: p50 %.0fms p95 %.0fms p99 %.0fms (%zu)",
+			stats.p50, stats.p95, stats.p99, stats.samples);
+		graphics::print(text, x, y);
+
+		std::uint32_t tallest = 1;
+		for (std::uint32_t count : stats.buckets)
+			tallest = std::max(tallest, count);
+		int base = y + 20 + graphHeight;
+		for (std::size_t i = 0; i < BUCKETS; i++) {
+			int height = stats.buckets[i] * graphHeight / tallest;
+			if (height > 0)
+				graphics::rectangleFilled(x + i * barWidth,
+					base - height, barWidth, height);
+		}
+		graphics::line(x, base, x + BUCKETS * barWidth, base);
+	}
+
+};
+
+}; // namespace Astrum
@@ -1,11 +1,25 @@
 #include <string>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <filesystem>
+#include <system_error>
 #include <cstdarg>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 
 #include "sdl.hpp"
 #include "astrum/log.hpp"
 #include "astrum/util.hpp"
+#include "astrum/filesystem.hpp"
 
 namespace Astrum {
 
@@ -38,8 +52,340 @@ namespace log {
 #endif
 		std::function<void(LogCategory, std::string)> writeFunction
 			= defaultWriteFunction;
+
+		// bounded multi-producer queue (after Dmitry Vyukov's); a slot is
+		// free for position `pos` when its sequence is `pos`, and holds a
+		// message for the writer when its sequence is `pos + 1`
+		struct Record {
+			std::atomic<std::size_t> sequence;
+			LogCategory cat;
+			std::size_t length;
+			char text[ASYNC_MESSAGE_SIZE];
+		};
+		static_assert((ASYNC_QUEUE_SIZE & (ASYNC_QUEUE_SIZE - 1)) == 0,
+			"ASYNC_QUEUE_SIZE must be a power of two");
+
+		std::unique_ptr<Record[]> queue;
+		alignas(64) std::atomic<std::size_t> enqueuePos { 0 };
+		alignas(64) std::atomic<std::size_t> dequeuePos { 0 };
+		std::atomic<std::uint64_t> queued { 0 };
+		std::atomic<std::uint64_t> written { 0 };
+		std::atomic<std::uint64_t> dropped { 0 };
+
+		std::atomic<bool> asyncEnabled { false };
+		std::atomic<bool> writerRunning { false };
+		std::atomic<bool> writerIdle { false };
+		// threads between checking `asyncEnabled` and publishing a record,
+		// which `stopAsync` waits out before stopping the writer
+		std::atomic<int> producers { 0 };
+		OverflowPolicy overflow = OverflowPolicy::drop;
+		std::thread writer;
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+
+		// the file sink may be written from any thread in synchronous mode
+		std::mutex fileMutex;
+		SDL_RWops *logFile = nullptr;
+		std::atomic<bool> fileOpen { false };
+		LogFileOptions fileOptions;
+		std::filesystem::path logDirectory;
+		std::vector<char> fileBuffer;
+		// bytes in the current file, including those still buffered
+		std::size_t fileSize = 0;
+		// bytes of the current file's header, before any record
+		std::size_t headerSize = 0;
 	};
 
+	static std::filesystem::path logFilePath(int index) {
+		std::string name = "astrum";
+		if (index > 0)
+			name += "." + std::to_string(index);
+		name += fileOptions.binary ? ".alog" : ".log";
+		return logDirectory / name;
+	}
+
+	static void flushFileBuffer() {
+		if (logFile != nullptr && !fileBuffer.empty())
+			SDL_RWwrite(logFile, fileBuffer.data(), 1, fileBuffer.size());
+		fileBuffer.clear();
+	}
+
+	static void putLE(std::uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; i++)
+			fileBuffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+	}
+
+	static void writeFileHeader() {
+		std::time_t now = std::time(nullptr);
+		if (fileOptions.binary) {
+			fileBuffer.insert(fileBuffer.end(), LOG_FILE_MAGIC,
+				LOG_FILE_MAGIC + 8);
+			putLE(static_cast<std::uint64_t>(now), 8);
+		} else {
+			char stamp[32];
+			std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S",
+				std::localtime(&now));
+			std::string line = util::strformat("# log opened %s\n", stamp);
+			fileBuffer.insert(fileBuffer.end(), line.begin(), line.end());
+		}
+		fileSize = headerSize = fileBuffer.size();
+	}
+
+	// moves astrum.log to astrum.1.log and so on, dropping the oldest
+	static void rotateFiles() {
+		std::error_code err;
+		std::filesystem::remove(logFilePath(fileOptions.maxFiles - 1), err);
+		for (int i = fileOptions.maxFiles - 2; i >= 0; i--)
+			std::filesystem::rename(logFilePath(i), logFilePath(i + 1), err);
+	}
+
+	static bool openCurrentFile() {
+		rotateFiles();
+		logFile = SDL_RWFromFile(logFilePath(0).string().c_str(), "wb");
+		if (logFile == nullptr)
+			return false;
+		writeFileHeader();
+		return true;
+	}
+
+	static const char *categoryName(LogCategory cat) {
+		switch (cat) {
+		case LogCategory::debug:
+			return "DEBUG";
+		case LogCategory::info:
+			return "INFO";
+		case LogCategory::warn:
+			return "WARN";
+		case LogCategory::error:
+			return "ERROR";
+		}
+		return "";
+	}
+
+	static void writeToFile(LogCategory cat, const std::string &str) {
+		std::lock_guard<std::mutex> lock(fileMutex);
+		if (logFile == nullptr)
+			return;
+		// records are line-based, so the usual trailing newline is implied
+		std::size_t len = str.size();
+		if (len > 0 && str[len - 1] == '\n')
+			len--;
+		Uint32 ticks = SDL_GetTicks();
+
+		char prefix[32];
+		std::size_t prefixLen = 0;
+		std::size_t recordSize;
+		if (fileOptions.binary) {
+			len = std::min<std::size_t>(len, 0xFFFF);
+			recordSize = 7 + len;
+		} else {
+			prefixLen = std::snprintf(prefix, sizeof(prefix), "[%10.3f] %s: ",
+				ticks / 1000.0, categoryName(cat));
+			recordSize = prefixLen + len + 1;
+		}
+
+		// a record too large for even a fresh file goes in as it is, rather
+		// than rotating away every older file on its own
+		if (fileSize > headerSize
+			&& fileSize + recordSize > fileOptions.maxFileSize) {
+			flushFileBuffer();
+			SDL_RWclose(logFile);
+			logFile = nullptr;
+			if (!openCurrentFile()) {
+				fileOpen = false;
+				return;
+			}
+		}
+
+		if (fileOptions.binary) {
+			fileBuffer.push_back(static_cast<char>(cat));
+			putLE(ticks, 4);
+			putLE(len, 2);
+			fileBuffer.insert(fileBuffer.end(), str.begin(), str.begin() + len);
+		} else {
+			fileBuffer.insert(fileBuffer.end(), prefix, prefix + prefixLen);
+			fileBuffer.insert(fileBuffer.end(), str.begin(), str.begin() + len);
+			fileBuffer.push_back('\n');
+		}
+		fileSize += recordSize;
+
+		if (fileBuffer.size() >= fileOptions.bufferSize
+			|| cat == LogCategory::error)
+			flushFileBuffer();
+	}
+
+	// every message ends up here, on the writer thread in asynchronous mode
+	static void writeMessage(LogCategory cat, const std::string &str) {
+		if (fileOpen.load(std::memory_order_acquire)) {
+			writeToFile(cat, str);
+			if (!fileOptions.echo)
+				return;
+		}
+		writeFunction(cat, str);
+	}
+
+	bool openFile(const LogFileOptions &options) {
+		std::lock_guard<std::mutex> lock(fileMutex);
+		if (logFile != nullptr)
+			return true;
+		fileOptions = options;
+		fileOptions.maxFiles = std::max(fileOptions.maxFiles, 1);
+		logDirectory = filesystem::getAppDirectory() / "logs";
+		std::error_code err;
+		std::filesystem::create_directories(logDirectory, err);
+		fileBuffer.reserve(fileOptions.bufferSize + ASYNC_MESSAGE_SIZE);
+		if (!openCurrentFile()) {
+			writeFunction(LogCategory::error, util::strformat(
+				"Could not open log file in %s: %s\n",
+				logDirectory.string().c_str(), SDL_GetError()));
+			return false;
+		}
+		fileOpen = true;
+		return true;
+	}
+
+	void closeFile() {
+		std::lock_guard<std::mutex> lock(fileMutex);
+		if (logFile == nullptr)
+			return;
+		fileOpen = false;
+		flushFileBuffer();
+		SDL_RWclose(logFile);
+		logFile = nullptr;
+	}
+
+	bool isFileOpen() {
+		return fileOpen;
+	}
+
+	static Record *claimSlot(std::size_t &pos) {
+		pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true) {
+			Record &rec = queue[pos & (ASYNC_QUEUE_SIZE - 1)];
+			std::size_t seq = rec.sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::intptr_t>(seq)
+				- static_cast<std::intptr_t>(pos);
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+					std::memory_order_relaxed))
+					return &rec;
+			} else if (diff < 0) {
+				// the writer hasn't freed this slot yet
+				return nullptr;
+			} else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	static void pushRecord(LogCategory cat, const char *format, va_list args) {
+		std::size_t pos;
+		Record *rec = claimSlot(pos);
+		while (rec == nullptr) {
+			if (overflow == OverflowPolicy::drop) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			// nothing will free a slot once the writer is gone
+			if (!writerRunning.load(std::memory_order_acquire)) {
+				writeMessage(cat, util::vstrformat(format, args));
+				return;
+			}
+			wake.notify_one();
+			std::this_thread::yield();
+			rec = claimSlot(pos);
+		}
+		int len = std::vsnprintf(rec->text, ASYNC_MESSAGE_SIZE, format, args);
+		rec->cat = cat;
+		rec->length = std::min<std::size_t>(std::max(len, 0),
+			ASYNC_MESSAGE_SIZE - 1);
+		rec->sequence.store(pos + 1, std::memory_order_release);
+		queued.fetch_add(1, std::memory_order_release);
+		if (writerIdle.load(std::memory_order_relaxed))
+			wake.notify_one();
+	}
+
+	// only ever called from the writer thread
+	static bool popRecord() {
+		std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		Record &rec = queue[pos & (ASYNC_QUEUE_SIZE - 1)];
+		std::size_t seq = rec.sequence.load(std::memory_order_acquire);
+		if (seq != pos + 1)
+			return false;
+		dequeuePos.store(pos + 1, std::memory_order_relaxed);
+		writeMessage(rec.cat, std::string(rec.text, rec.length));
+		rec.sequence.store(pos + ASYNC_QUEUE_SIZE, std::memory_order_release);
+		written.fetch_add(1, std::memory_order_release);
+		return true;
+	}
+
+	static void writerLoop() {
+		while (writerRunning.load(std::memory_order_acquire)) {
+			bool any = false;
+			while (popRecord())
+				any = true;
+			if (any)
+				continue;
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			writerIdle.store(true, std::memory_order_relaxed);
+			// the timeout covers a producer missing `writerIdle`
+			wake.wait_for(lock, std::chrono::milliseconds(5));
+			writerIdle.store(false, std::memory_order_relaxed);
+		}
+		while (popRecord()) { }
+	}
+
+	void startAsync(OverflowPolicy policy) {
+#ifndef __EMSCRIPTEN__
+		if (writerRunning)
+			return;
+		overflow = policy;
+		if (queue == nullptr)
+			queue = std::make_unique<Record[]>(ASYNC_QUEUE_SIZE);
+		for (std::size_t i = 0; i < ASYNC_QUEUE_SIZE; i++)
+			queue[i].sequence.store(i, std::memory_order_relaxed);
+		enqueuePos = dequeuePos = 0;
+		queued = written = 0;
+		writerRunning = true;
+		writer = std::thread(writerLoop);
+		asyncEnabled = true;
+#else
+		(void) policy;
+#endif
+	}
+
+	void stopAsync() {
+		if (!writerRunning)
+			return;
+		asyncEnabled = false;
+		// let records already being written be published and drained
+		while (producers.load() > 0) {
+			wake.notify_one();
+			std::this_thread::yield();
+		}
+		writerRunning = false;
+		wake.notify_one();
+		writer.join();
+	}
+
+	bool isAsync() {
+		return asyncEnabled;
+	}
+
+	void flush() {
+		while (writerRunning && written.load(std::memory_order_acquire)
+			< queued.load(std::memory_order_acquire)) {
+			wake.notify_one();
+			std::this_thread::yield();
+		}
+		std::lock_guard<std::mutex> lock(fileMutex);
+		flushFileBuffer();
+	}
+
+	std::uint64_t getDroppedCount() {
+		return dropped;
+	}
+
 	LogCategory getLogPriority() {
 		return outputLevel;
 	}
@@ -47,49 +393,58 @@ namespace log {
 		outputLevel = priority;
 	}
 
-	void vlog(LogCategory cat, std::string format, va_list args) {
+	void vlog(LogCategory cat, const char *format, va_list args) {
 		// if the message is below the output level, it is ignored
 		if (cat < outputLevel)
 			return;
+		// sequentially consistent, so `stopAsync` either sees this thread
+		// in `producers` or this thread sees async mode turned off
+		producers.fetch_add(1);
+		if (asyncEnabled.load()) {
+			pushRecord(cat, format, args);
+			producers.fetch_sub(1);
+			return;
+		}
+		producers.fetch_sub(1);
 		std::string str = util::vstrformat(format, args);
-		writeFunction(cat, str);
+		writeMessage(cat, str);
 	}
-	void vlog(std::string format, va_list args) {
+	void vlog(const char *format, va_list args) {
 		vlog(LogCategory::info, format, args);
 	}
 
-	void log(LogCategory cat, std::string format, ...) {
+	void log(LogCategory cat, const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		vlog(cat, format, args);
 		va_end(args);
 	}
-	void log(std::string format, ...) {
+	void log(const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		vlog(LogCategory::info, format, args);
 		va_end(args);
 	}
 
-	void info(std::string format, ...) {
+	void info(const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		vlog(LogCategory::info, format, args);
 		va_end(args);
 	}
-	void debug(std::string format, ...) {
+	void debug(const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		vlog(LogCategory::debug, format, args);
 		va_end(args);
 	}
-	void warn(std::string format, ...) {
+	void warn(const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		vlog(LogCategory::warn, format, args);
 		va_end(args);
 	}
-	void error(std::string format, ...) {
+	void error(const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		vlog(LogCategory::error, format, args);
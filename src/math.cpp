@@ -1,50 +1,163 @@
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
 #include <utility>
 #include <type_traits>
 #include <random>
 
+#include "internals.hpp"
 #include "astrum/constants.hpp"
 #include "astrum/math.hpp"
+#include "astrum/util.hpp"
+
+#if defined(__AVX__)
+#	include <immintrin.h>
+#elif defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
 
 namespace Astrum {
 
 namespace math {
 
+	static std::uint64_t splitmix64(std::uint64_t &x) {
+		x += 0x9E3779B97F4A7C15;
+		std::uint64_t z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+		return z ^ (z >> 31);
+	}
+
+	RandomGenerator::RandomGenerator(std::uint64_t seed, std::uint64_t stream) {
+		// other streams start from the seed mixed with a splitmix64 pass over
+		// the stream number, so picking one costs the same for any stream;
+		// stream 0 keeps the seed's own state
+		if (stream != 0)
+			seed ^= splitmix64(stream);
+		// splitmix64, so that similar seeds give unrelated states
+		for (std::uint64_t &word : this->s)
+			word = splitmix64(seed);
+	}
+
+	void RandomGenerator::jump() {
+		static constexpr std::uint64_t JUMP[] = {
+			0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C,
+			0xA9582618E03FC9AA, 0x39ABDC4529B1661C
+		};
+		std::uint64_t out[4] = { 0, 0, 0, 0 };
+		for (std::uint64_t word : JUMP) {
+			for (int bit = 0; bit < 64; bit++) {
+				if (word & (std::uint64_t(1) << bit)) {
+					for (int i = 0; i < 4; i++)
+						out[i] ^= this->s[i];
+				}
+				(*this)();
+			}
+		}
+		for (int i = 0; i < 4; i++)
+			this->s[i] = out[i];
+	}
+
 	namespace {
-		unsigned seed;
-		std::mt19937 rng;
+		std::atomic<unsigned> seed { 0 };
+		// bumped by every reseed, so threads know to pick a new stream
+		std::atomic<std::uint64_t> generation { 1 };
+		std::atomic<std::uint64_t> nextStream { 0 };
+
+		struct ThreadState {
+			RandomGenerator rng;
+			std::uint64_t generation = 0;
+		};
+		thread_local ThreadState local;
 	};
 
-	// uses a Mersenne Twister, so is not
-	// suitable for cryptographic purposes
+	static RandomGenerator &generator() {
+		std::uint64_t gen = generation.load(std::memory_order_acquire);
+		if (local.generation != gen) {
+			local.rng = RandomGenerator(seed.load(std::memory_order_relaxed),
+				nextStream.fetch_add(1, std::memory_order_relaxed));
+			local.generation = gen;
+		}
+		return local.rng;
+	}
+
+	static void reseed(unsigned s) {
+		seed.store(s, std::memory_order_relaxed);
+		// the calling thread takes stream 0
+		nextStream.store(1, std::memory_order_relaxed);
+		local.rng = RandomGenerator(s, 0);
+		local.generation = generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+	}
+
 	void InitMath() {
 		std::random_device rd;
-		seed = rd();
-		rng = std::mt19937(seed);
+		reseed(rd());
 	}
 
 	unsigned random() {
-		return rng();
+		return generator().next32();
 	}
 	unsigned random(unsigned max) {
-		std::uniform_int_distribution<> distr(0, max);
-		return distr(rng);
+		return generator().bounded(max + 1);
 	}
 	unsigned random(unsigned min, unsigned max) {
-		std::uniform_int_distribution<> distr(min, max);
-		return distr(rng);
+		return min + generator().bounded(max - min + 1);
 	}
 
 	double randfloat(double max) {
-		return (double) rng() / ((double) std::mt19937::max() / max);
+		return generator().nextDouble() * max;
 	}
 	double randfloat(double min, double max) {
 		return min + randfloat(max - min);
 	}
 
+	unsigned getSeed() {
+		return seed;
+	}
+
 	void randomseed(unsigned s) {
-		seed = s;
-		rng = std::mt19937(seed);
+		// recordings store the seed, and replays substitute it
+		reseed(replay::filterSeed(s));
+	}
+
+	void randomstream(std::uint64_t stream) {
+		local.rng = RandomGenerator(seed.load(std::memory_order_relaxed), stream);
+		local.generation = generation.load(std::memory_order_acquire);
+	}
+
+	RandomGenerator &getRandomGenerator() {
+		return generator();
+	}
+
+	// the fills draw from a copy on the stack, so the compiler can keep the
+	// state in registers rather than reloading the thread-local each time
+	void fillrandom(Span<unsigned> out, unsigned min, unsigned max) {
+		RandomGenerator &shared = generator();
+		RandomGenerator rng = shared;
+		std::uint32_t range = max - min + 1;
+		for (unsigned &val : out)
+			val = min + rng.bounded(range);
+		shared = rng;
+	}
+
+	void fillrandfloat(Span<float> out, float min, float max) {
+		RandomGenerator &shared = generator();
+		RandomGenerator rng = shared;
+		float scale = max - min;
+		for (float &val : out)
+			val = min + rng.nextFloat() * scale;
+		shared = rng;
+	}
+
+	void fillrandfloat(Span<double> out, double min, double max) {
+		RandomGenerator &shared = generator();
+		RandomGenerator rng = shared;
+		double scale = max - min;
+		for (double &val : out)
+			val = min + rng.nextDouble() * scale;
+		shared = rng;
 	}
 
 	inline double log(double val) {
@@ -54,6 +167,102 @@ namespace math {
 		return std::log(val) / std::log(base);
 	}
 
+	// the kernels treat spans of these as packed floats
+	static_assert(sizeof(Vec2) == 2 * sizeof(float), "Vec2 must be packed");
+	static_assert(sizeof(Rect) == 4 * sizeof(float), "Rect must be packed");
+
+	void transformPoints(const Mat3 &mat, Span<const Vec2> in, Span<Vec2> out) {
+		std::size_t count = std::min(in.size(), out.size());
+		const float *src = reinterpret_cast<const float *>(in.data());
+		float *dst = reinterpret_cast<float *>(out.data());
+		std::size_t i = 0;
+		// points are interleaved x, y, so with each x and y copied across
+		// its pair of lanes, every lane computes x * a + y * c + t for its
+		// own row of the matrix
+#ifdef __AVX__
+		const __m256 ab8 = _mm256_setr_ps(mat.a, mat.b, mat.a, mat.b,
+			mat.a, mat.b, mat.a, mat.b);
+		const __m256 cd8 = _mm256_setr_ps(mat.c, mat.d, mat.c, mat.d,
+			mat.c, mat.d, mat.c, mat.d);
+		const __m256 t8 = _mm256_setr_ps(mat.tx, mat.ty, mat.tx, mat.ty,
+			mat.tx, mat.ty, mat.tx, mat.ty);
+		for (; i + 4 <= count; i += 4) {
+			__m256 pts = _mm256_loadu_ps(src + i * 2);
+			__m256 xs = _mm256_moveldup_ps(pts);
+			__m256 ys = _mm256_movehdup_ps(pts);
+			__m256 res = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xs, ab8),
+				_mm256_mul_ps(ys, cd8)), t8);
+			_mm256_storeu_ps(dst + i * 2, res);
+		}
+#endif
+#ifdef __SSE2__
+		const __m128 ab = _mm_setr_ps(mat.a, mat.b, mat.a, mat.b);
+		const __m128 cd = _mm_setr_ps(mat.c, mat.d, mat.c, mat.d);
+		const __m128 t = _mm_setr_ps(mat.tx, mat.ty, mat.tx, mat.ty);
+		for (; i + 2 <= count; i += 2) {
+			__m128 pts = _mm_loadu_ps(src + i * 2);
+			__m128 xs = _mm_shuffle_ps(pts, pts, _MM_SHUFFLE(2, 2, 0, 0));
+			__m128 ys = _mm_shuffle_ps(pts, pts, _MM_SHUFFLE(3, 3, 1, 1));
+			__m128 res = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, ab),
+				_mm_mul_ps(ys, cd)), t);
+			_mm_storeu_ps(dst + i * 2, res);
+		}
+#endif
+		for (; i < count; i++)
+			out[i] = mat.apply(in[i]);
+	}
+
+	void transformRects(const Mat3 &mat, Span<const Rect> in, Span<Rect> out) {
+		std::size_t count = std::min(in.size(), out.size());
+		std::size_t i = 0;
+#ifdef __SSE2__
+		// four rects at a time, transposed so each register holds one field
+		// of all four; the same centre and extents as `Mat3::applyRect`
+		const float *src = reinterpret_cast<const float *>(in.data());
+		float *dst = reinterpret_cast<float *>(out.data());
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 a = _mm_set1_ps(mat.a);
+		const __m128 b = _mm_set1_ps(mat.b);
+		const __m128 c = _mm_set1_ps(mat.c);
+		const __m128 d = _mm_set1_ps(mat.d);
+		const __m128 tx = _mm_set1_ps(mat.tx);
+		const __m128 ty = _mm_set1_ps(mat.ty);
+		const __m128 absA = _mm_set1_ps(std::fabs(mat.a));
+		const __m128 absB = _mm_set1_ps(std::fabs(mat.b));
+		const __m128 absC = _mm_set1_ps(std::fabs(mat.c));
+		const __m128 absD = _mm_set1_ps(std::fabs(mat.d));
+		for (; i + 4 <= count; i += 4) {
+			__m128 xs = _mm_loadu_ps(src + i * 4);
+			__m128 ys = _mm_loadu_ps(src + i * 4 + 4);
+			__m128 ws = _mm_loadu_ps(src + i * 4 + 8);
+			__m128 hs = _mm_loadu_ps(src + i * 4 + 12);
+			_MM_TRANSPOSE4_PS(xs, ys, ws, hs);
+			__m128 hw = _mm_mul_ps(ws, half);
+			__m128 hh = _mm_mul_ps(hs, half);
+			__m128 cx = _mm_add_ps(xs, hw);
+			__m128 cy = _mm_add_ps(ys, hh);
+			__m128 ncx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, cx),
+				_mm_mul_ps(c, cy)), tx);
+			__m128 ncy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, cx),
+				_mm_mul_ps(d, cy)), ty);
+			__m128 ex = _mm_add_ps(_mm_mul_ps(absA, hw), _mm_mul_ps(absC, hh));
+			__m128 ey = _mm_add_ps(_mm_mul_ps(absB, hw), _mm_mul_ps(absD, hh));
+			xs = _mm_sub_ps(ncx, ex);
+			ys = _mm_sub_ps(ncy, ey);
+			ws = _mm_mul_ps(ex, two);
+			hs = _mm_mul_ps(ey, two);
+			_MM_TRANSPOSE4_PS(xs, ys, ws, hs);
+			_mm_storeu_ps(dst + i * 4, xs);
+			_mm_storeu_ps(dst + i * 4 + 4, ys);
+			_mm_storeu_ps(dst + i * 4 + 8, ws);
+			_mm_storeu_ps(dst + i * 4 + 12, hs);
+		}
+#endif
+		for (; i < count; i++)
+			out[i] = mat.applyRect(in[i]);
+	}
+
 }
 
 }; // namespace Astrum
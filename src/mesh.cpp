@@ -0,0 +1,266 @@
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/mesh.hpp"
+#include "astrum/graphics.hpp"
+#include "astrum/image.hpp"
+#include "astrum/math.hpp"
+#include "astrum/profile.hpp"
+
+namespace Astrum {
+
+namespace {
+	constexpr float FULL_TURN = 6.28318531f;
+
+	// one outline of a shape, pushed out from its edge by `offset`
+	struct Ring {
+		float offset;
+		std::uint8_t alpha;
+	};
+};
+
+struct MeshData {
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+	std::optional<Image> image;
+	Rect bounds;
+	// the vertices once transformed, rebuilt on every draw
+	std::vector<SDL_Vertex> transformed;
+
+	void updateBounds() {
+		if (this->vertices.empty()) {
+			this->bounds = Rect();
+			return;
+		}
+		float minX = this->vertices[0].position.x;
+		float maxX = minX;
+		float minY = this->vertices[0].position.y;
+		float maxY = minY;
+		for (const SDL_Vertex &vert : this->vertices) {
+			minX = std::min(minX, vert.position.x);
+			maxX = std::max(maxX, vert.position.x);
+			minY = std::min(minY, vert.position.y);
+			maxY = std::max(maxY, vert.position.y);
+		}
+		this->bounds = Rect(minX, minY, maxX - minX, maxY - minY);
+	}
+
+	// stretches texture coordinates across the bounds
+	void fitTexCoords() {
+		this->updateBounds();
+		float w = this->bounds.w > 0.0f ? this->bounds.w : 1.0f;
+		float h = this->bounds.h > 0.0f ? this->bounds.h : 1.0f;
+		for (SDL_Vertex &vert : this->vertices) {
+			vert.tex_coord.x = (vert.position.x - this->bounds.x) / w;
+			vert.tex_coord.y = (vert.position.y - this->bounds.y) / h;
+		}
+	}
+
+	int addVertex(float x, float y, std::uint8_t alpha) {
+		this->vertices.push_back({ { x, y }, { 0xFF, 0xFF, 0xFF, alpha },
+			{ 0.0f, 0.0f } });
+		return static_cast<int>(this->vertices.size() - 1);
+	}
+
+	void addQuad(int a, int b, int c, int d) {
+		this->indices.insert(this->indices.end(), { a, b, c, a, c, d });
+	}
+
+	// rings of points along an elliptical arc, each stitched to the next
+	// with quads; returns the index of the first point of each ring
+	std::vector<int> addBand(float rx, float ry, float from, float to,
+		int segments, bool closed, std::initializer_list<Ring> rings) {
+		int points = closed ? segments : segments + 1;
+		std::vector<int> starts;
+		for (const Ring &ring : rings) {
+			starts.push_back(static_cast<int>(this->vertices.size()));
+			float ox = std::max(rx + ring.offset, 0.0f);
+			float oy = std::max(ry + ring.offset, 0.0f);
+			for (int i = 0; i < points; i++) {
+				float angle = from + (to - from) * i / segments;
+				this->addVertex(std::cos(angle) * ox, std::sin(angle) * oy,
+					ring.alpha);
+			}
+		}
+		for (std::size_t r = 0; r + 1 < starts.size(); r++) {
+			for (int i = 0; i < segments; i++) {
+				int next = (i + 1) % points;
+				this->addQuad(starts[r] + i, starts[r] + next,
+					starts[r + 1] + next, starts[r + 1] + i);
+			}
+		}
+		return starts;
+	}
+
+	// a fan from the centre to the first ring of a band
+	void addFan(int center, int start, int segments, bool closed) {
+		int points = closed ? segments : segments + 1;
+		for (int i = 0; i < segments; i++) {
+			this->indices.insert(this->indices.end(),
+				{ center, start + i, start + (i + 1) % points });
+		}
+	}
+
+	void filled(float rx, float ry, float from, float to, int segments,
+		float fringe, bool closed) {
+		segments = std::max(segments, 3);
+		int center = this->addVertex(0.0f, 0.0f, 0xFF);
+		std::vector<int> starts = fringe > 0.0f
+			? this->addBand(rx, ry, from, to, segments, closed,
+				{ { -fringe / 2, 0xFF }, { fringe / 2, 0x00 } })
+			: this->addBand(rx, ry, from, to, segments, closed,
+				{ { 0.0f, 0xFF } });
+		this->addFan(center, starts[0], segments, closed);
+		this->fitTexCoords();
+	}
+
+	void outline(float rx, float ry, float from, float to, float thickness,
+		int segments, float fringe, bool closed) {
+		segments = std::max(segments, 3);
+		float half = thickness / 2;
+		if (fringe > 0.0f)
+			this->addBand(rx, ry, from, to, segments, closed,
+				{ { -half - fringe / 2, 0x00 }, { -half + fringe / 2, 0xFF },
+				{ half - fringe / 2, 0xFF }, { half + fringe / 2, 0x00 } });
+		else
+			this->addBand(rx, ry, from, to, segments, closed,
+				{ { -half, 0xFF }, { half, 0xFF } });
+		this->fitTexCoords();
+	}
+};
+
+Mesh::Mesh() : data(std::make_shared<MeshData>()) { }
+Mesh::Mesh(Span<const Vertex> vertices, Span<const int> indices) : Mesh() {
+	this->setVertices(vertices);
+	this->setIndices(indices);
+}
+
+Mesh Mesh::ellipse(float rx, float ry, int segments, float fringe) {
+	Mesh mesh;
+	mesh.data->filled(rx, ry, 0.0f, FULL_TURN, segments, fringe, true);
+	return mesh;
+}
+
+Mesh Mesh::circle(float radius, int segments, float fringe) {
+	return ellipse(radius, radius, segments, fringe);
+}
+
+Mesh Mesh::pie(float radius, float from, float to, int segments,
+	float fringe) {
+	Mesh mesh;
+	mesh.data->filled(radius, radius, from, to, segments, fringe, false);
+	return mesh;
+}
+
+Mesh Mesh::ring(float rx, float ry, float thickness, int segments,
+	float fringe) {
+	Mesh mesh;
+	mesh.data->outline(rx, ry, 0.0f, FULL_TURN, thickness, segments,
+		fringe, true);
+	return mesh;
+}
+
+Mesh Mesh::arc(float radius, float from, float to, float thickness,
+	int segments, float fringe) {
+	Mesh mesh;
+	mesh.data->outline(radius, radius, from, to, thickness, segments, fringe,
+		false);
+	return mesh;
+}
+
+static Uint8 modulate(Uint8 channel, std::uint8_t tint) {
+	return static_cast<Uint8>((channel * tint + 0x7F) / 0xFF);
+}
+
+void Mesh::draw(const graphics::DrawParams &params) const {
+	ASTRUM_PROFILE_SCOPE("Mesh::draw");
+	MeshData &d = *this->data;
+	if (d.vertices.empty())
+		return;
+	Mat3 flip = Mat3::scaling(params.flipX ? -1.0f : 1.0f,
+		params.flipY ? -1.0f : 1.0f);
+	Mat3 m = graphics::getTransform() * params.getTransform() * flip;
+	if (graphics::cull(m.applyRect(d.bounds)))
+		return;
+	SDL_Texture *texture = nullptr;
+	if (d.image)
+		texture = graphics::getTexture(*d.image->getData());
+
+	const Color tint = params.tint;
+	bool tinted = tint.r != 0xFF || tint.g != 0xFF || tint.b != 0xFF
+		|| tint.a != 0xFF;
+	d.transformed.resize(d.vertices.size());
+	for (std::size_t i = 0; i < d.vertices.size(); i++) {
+		const SDL_Vertex &src = d.vertices[i];
+		SDL_Vertex &dst = d.transformed[i];
+		Vec2 p = m.apply(Vec2(src.position.x, src.position.y));
+		dst.position = { p.x, p.y };
+		dst.tex_coord = src.tex_coord;
+		dst.color = src.color;
+		if (tinted) {
+			dst.color.r = modulate(src.color.r, tint.r);
+			dst.color.g = modulate(src.color.g, tint.g);
+			dst.color.b = modulate(src.color.b, tint.b);
+			dst.color.a = modulate(src.color.a, tint.a);
+		}
+	}
+	graphics::geometry(texture, d.transformed, d.indices);
+}
+
+void Mesh::draw(float x, float y) const {
+	this->draw(graphics::DrawParams(x, y));
+}
+
+std::size_t Mesh::getVertexCount() const {
+	return this->data->vertices.size();
+}
+
+Mesh::Vertex Mesh::getVertex(std::size_t index) const {
+	const SDL_Vertex &vert = this->data->vertices.at(index);
+	return Vertex { Vec2(vert.position.x, vert.position.y),
+		Vec2(vert.tex_coord.x, vert.tex_coord.y),
+		Color(vert.color.r, vert.color.g, vert.color.b, vert.color.a) };
+}
+
+void Mesh::setVertex(std::size_t index, const Vertex &vertex) {
+	SDL_Vertex &vert = this->data->vertices.at(index);
+	vert = { { vertex.position.x, vertex.position.y },
+		{ vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a },
+		{ vertex.uv.x, vertex.uv.y } };
+	this->data->updateBounds();
+}
+
+void Mesh::setVertices(Span<const Vertex> vertices) {
+	MeshData &d = *this->data;
+	d.vertices.clear();
+	d.vertices.reserve(vertices.size());
+	for (const Vertex &vertex : vertices) {
+		d.vertices.push_back({ { vertex.position.x, vertex.position.y },
+			{ vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a },
+			{ vertex.uv.x, vertex.uv.y } });
+	}
+	d.updateBounds();
+}
+
+void Mesh::setIndices(Span<const int> indices) {
+	this->data->indices.assign(indices.begin(), indices.end());
+}
+
+void Mesh::setImage(std::optional<Image> image) {
+	this->data->image = image;
+}
+
+Rect Mesh::getBounds() const {
+	return this->data->bounds;
+}
+
+}; // namespace Astrum
@@ -1,6 +1,8 @@
 #include <unordered_map>
+#include <vector>
 #include <tuple>
 #include <optional>
+#include <initializer_list>
 #include <memory>
 
 #include "sdl.hpp"
@@ -10,6 +12,7 @@
 #include "astrum/astrum.hpp"
 #include "astrum/graphics.hpp"
 #include "astrum/image.hpp"
+#include "astrum/event.hpp"
 
 namespace Astrum {
 
@@ -34,8 +37,47 @@ namespace mouse {
 
 	namespace {
 		std::unordered_map<MouseButton, bool> mousedown;
+
+		// motion received since the last flush, in window coordinates
+		bool motionPending = false;
+		int motionX = 0, motionY = 0;
+		int motionDX = 0, motionDY = 0;
+
+		bool rawMotion = false;
+		std::vector<MouseMotion> rawSamples;
 	};
 
+	void addMotion(const SDL_Event &e) {
+		motionPending = true;
+		motionX = e.motion.x;
+		motionY = e.motion.y;
+		motionDX += e.motion.xrel;
+		motionDY += e.motion.yrel;
+		if (rawMotion) {
+			rawSamples.push_back({ e.motion.x, e.motion.y, e.motion.xrel,
+				e.motion.yrel, e.motion.timestamp });
+		}
+	}
+
+	void flushMotion() {
+		if (!rawSamples.empty()) {
+			for (MouseMotion &sample : rawSamples) {
+				std::tie(sample.x, sample.y) =
+					graphics::getVirtualCoords(sample.x, sample.y);
+			}
+			event::mousemotionraw.dispatch(Span<const MouseMotion>(rawSamples));
+			// keeps its capacity, so steady-state frames don't allocate
+			rawSamples.clear();
+		}
+		if (!motionPending)
+			return;
+		auto [virtX, virtY] = graphics::getVirtualCoords(motionX, motionY);
+		int dx = motionDX, dy = motionDY;
+		motionPending = false;
+		motionDX = motionDY = 0;
+		event::mousemoved.dispatch(virtX, virtY, dx, dy);
+	}
+
 	void addMousedown(MouseButton btn) {
 		mousedown[btn] = true;
 	}
@@ -80,6 +122,14 @@ namespace mouse {
 		CURSOR_HAND      = createSystemCursor(SDL_SYSTEM_CURSOR_HAND);
 	}
 
+	void QuitMouse() {
+		for (std::optional<Cursor> *cursor : { &CURSOR_ARROW, &CURSOR_IBEAM,
+			&CURSOR_WAIT, &CURSOR_CROSSHAIR, &CURSOR_WAITARROW,
+			&CURSOR_SIZENWSE, &CURSOR_SIZENESW, &CURSOR_SIZEWE,
+			&CURSOR_SIZENS, &CURSOR_SIZEALL, &CURSOR_NO, &CURSOR_HAND })
+			cursor->reset();
+	}
+
 	bool isdown(MouseButton button) {
 		return mousedown[button];
 	}
@@ -135,6 +185,16 @@ namespace mouse {
 		std::shared_ptr<CursorData> data = cursor.getData();
 		SDL_SetCursor(data->cursor);
 	}
+
+	bool hasRawMotion() {
+		return rawMotion;
+	}
+
+	void setRawMotion(bool state) {
+		rawMotion = state;
+		if (state)
+			rawSamples.reserve(256);
+	}
 };
 
 }; // namespace Astrum
@@ -0,0 +1,353 @@
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/particles.hpp"
+#include "astrum/image.hpp"
+#include "astrum/math.hpp"
+#include "astrum/profile.hpp"
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+namespace Astrum {
+
+namespace {
+	// below this many particles a thread costs more to start than it saves
+	constexpr std::size_t PARTICLES_PER_THREAD = 16384;
+
+	struct Field {
+		float min;
+		float max;
+	};
+};
+
+struct ParticleData {
+	std::size_t capacity;
+	std::size_t count = 0;
+	// one array per attribute, `capacity` long
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> velX;
+	std::vector<float> velY;
+	std::vector<float> age;
+	std::vector<float> lifetime;
+
+	bool active = true;
+	float emissionRate = 0.0f;
+	float emitPending = 0.0f;
+	float x = 0.0f;
+	float y = 0.0f;
+	float areaWidth = 0.0f;
+	float areaHeight = 0.0f;
+	float direction = 0.0f;
+	float spread = 0.0f;
+	Field speed = { 0.0f, 0.0f };
+	Field life = { 1.0f, 1.0f };
+	float accelX = 0.0f;
+	float accelY = 0.0f;
+	float damping = 0.0f;
+	float sizeStart = 4.0f;
+	float sizeEnd = 4.0f;
+	Color colorStart = Color(0xFF, 0xFF, 0xFF, 0xFF);
+	Color colorEnd = Color(0xFF, 0xFF, 0xFF, 0xFF);
+	ParticleSystem::Shape shape = ParticleSystem::Shape::square;
+	std::optional<Image> image;
+	bool parallel = false;
+
+	// rebuilt on every draw, but never reallocated
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> quadIndices;
+
+	explicit ParticleData(std::size_t capacity) : capacity(capacity),
+		posX(capacity), posY(capacity), velX(capacity), velY(capacity),
+		age(capacity), lifetime(capacity) {
+		this->vertices.reserve(capacity * 4);
+		this->quadIndices.resize(capacity * 6);
+		for (std::size_t i = 0; i < capacity; i++) {
+			int base = static_cast<int>(i * 4);
+			int *quad = &this->quadIndices[i * 6];
+			quad[0] = base;
+			quad[1] = base + 1;
+			quad[2] = base + 2;
+			quad[3] = base;
+			quad[4] = base + 2;
+			quad[5] = base + 3;
+		}
+	}
+
+	void spawn(std::size_t num) {
+		num = std::min(num, this->capacity - this->count);
+		math::RandomGenerator &rng = math::getRandomGenerator();
+		auto between = [&rng](float min, float max) {
+			return min + (max - min) * rng.nextFloat();
+		};
+		for (std::size_t i = this->count; i < this->count + num; i++) {
+			float angle = this->direction + this->spread * (rng.nextFloat() - 0.5f);
+			float speed = between(this->speed.min, this->speed.max);
+			this->posX[i] = this->x + this->areaWidth * (rng.nextFloat() - 0.5f);
+			this->posY[i] = this->y + this->areaHeight * (rng.nextFloat() - 0.5f);
+			this->velX[i] = std::cos(angle) * speed;
+			this->velY[i] = std::sin(angle) * speed;
+			this->age[i] = 0.0f;
+			this->lifetime[i] = between(this->life.min, this->life.max);
+		}
+		this->count += num;
+	}
+
+	void integrate(std::size_t begin, std::size_t end, float dt) {
+		const float ax = this->accelX * dt;
+		const float ay = this->accelY * dt;
+		const float damp = 1.0f / (1.0f + this->damping * dt);
+		float *px = this->posX.data();
+		float *py = this->posY.data();
+		float *vx = this->velX.data();
+		float *vy = this->velY.data();
+		float *ages = this->age.data();
+		std::size_t i = begin;
+#ifdef __SSE2__
+		const __m128 ax4 = _mm_set1_ps(ax);
+		const __m128 ay4 = _mm_set1_ps(ay);
+		const __m128 damp4 = _mm_set1_ps(damp);
+		const __m128 dt4 = _mm_set1_ps(dt);
+		for (; i + 4 <= end; i += 4) {
+			__m128 vx4 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vx + i), ax4), damp4);
+			__m128 vy4 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vy + i), ay4), damp4);
+			_mm_storeu_ps(vx + i, vx4);
+			_mm_storeu_ps(vy + i, vy4);
+			_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i),
+				_mm_mul_ps(vx4, dt4)));
+			_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i),
+				_mm_mul_ps(vy4, dt4)));
+			_mm_storeu_ps(ages + i, _mm_add_ps(_mm_loadu_ps(ages + i), dt4));
+		}
+#endif
+		for (; i < end; i++) {
+			vx[i] = (vx[i] + ax) * damp;
+			vy[i] = (vy[i] + ay) * damp;
+			px[i] += vx[i] * dt;
+			py[i] += vy[i] * dt;
+			ages[i] += dt;
+		}
+	}
+
+	void integrateAll(float dt) {
+		std::size_t threads = 1;
+#ifndef __EMSCRIPTEN__
+		if (this->parallel) {
+			threads = std::min<std::size_t>(std::thread::hardware_concurrency(),
+				this->count / PARTICLES_PER_THREAD);
+			threads = std::max<std::size_t>(threads, 1);
+		}
+#endif
+		if (threads == 1) {
+			this->integrate(0, this->count, dt);
+			return;
+		}
+		// chunks of a multiple of 4, so only the last has a scalar tail
+		std::size_t chunk = ((this->count + threads - 1) / threads + 3)
+			& ~std::size_t(3);
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		for (std::size_t t = 1; t < threads; t++) {
+			std::size_t begin = std::min(t * chunk, this->count);
+			std::size_t end = std::min(begin + chunk, this->count);
+			workers.emplace_back([this, begin, end, dt]() {
+				this->integrate(begin, end, dt);
+			});
+		}
+		this->integrate(0, std::min(chunk, this->count), dt);
+		for (std::thread &worker : workers)
+			worker.join();
+	}
+
+	// swaps the last live particle into each dead one's slot
+	void removeDead() {
+		std::size_t i = 0;
+		while (i < this->count) {
+			if (this->age[i] < this->lifetime[i]) {
+				i++;
+				continue;
+			}
+			std::size_t last = --this->count;
+			this->posX[i] = this->posX[last];
+			this->posY[i] = this->posY[last];
+			this->velX[i] = this->velX[last];
+			this->velY[i] = this->velY[last];
+			this->age[i] = this->age[last];
+			this->lifetime[i] = this->lifetime[last];
+		}
+	}
+};
+
+ParticleSystem::ParticleSystem(std::size_t capacity)
+	: data(std::make_shared<ParticleData>(capacity)) { }
+ParticleSystem::ParticleSystem(Image image, std::size_t capacity)
+	: data(std::make_shared<ParticleData>(capacity)) {
+	this->data->image = image;
+}
+
+void ParticleSystem::update(double dt) {
+	ASTRUM_PROFILE_SCOPE("ParticleSystem::update");
+	ParticleData &d = *this->data;
+	float step = static_cast<float>(dt);
+	d.integrateAll(step);
+	d.removeDead();
+	if (d.active) {
+		d.emitPending += d.emissionRate * step;
+		std::size_t num = static_cast<std::size_t>(d.emitPending);
+		d.emitPending -= num;
+		d.spawn(num);
+	}
+}
+
+static SDL_Color lerpColor(Color start, Color end, float t) {
+	auto channel = [t](std::uint8_t from, std::uint8_t to) {
+		return static_cast<Uint8>(from + (to - from) * t);
+	};
+	return SDL_Color { channel(start.r, end.r), channel(start.g, end.g),
+		channel(start.b, end.b), channel(start.a, end.a) };
+}
+
+void ParticleSystem::draw(float x, float y) const {
+	ASTRUM_PROFILE_SCOPE("ParticleSystem::draw");
+	ParticleData &d = *this->data;
+	SDL_Texture *texture = nullptr;
+	if (d.image)
+		texture = graphics::getTexture(*d.image->getData());
+
+	// each particle is drawn at its transformed centre, with its corners
+	// along the transformed axes, and skipped if that lands off the view
+	Mat3 m = graphics::getTransform() * Mat3::translation(x, y);
+	Rect view = graphics::getViewBounds();
+	float extentX = std::abs(m.a) + std::abs(m.c);
+	float extentY = std::abs(m.b) + std::abs(m.d);
+
+	bool square = d.shape == Shape::square;
+	d.vertices.resize(d.count * (square ? 4 : 3));
+	SDL_Vertex *vert = d.vertices.data();
+	std::size_t drawn = 0;
+	for (std::size_t i = 0; i < d.count; i++) {
+		float t = d.age[i] < d.lifetime[i] ? d.age[i] / d.lifetime[i] : 1.0f;
+		float half = (d.sizeStart + (d.sizeEnd - d.sizeStart) * t) / 2;
+		Vec2 c = m.apply(Vec2(d.posX[i], d.posY[i]));
+		float rx = extentX * half;
+		float ry = extentY * half;
+		if (c.x + rx < view.left() || c.x - rx > view.right()
+			|| c.y + ry < view.top() || c.y - ry > view.bottom())
+			continue;
+		Vec2 ex = Vec2(m.a, m.b) * half;
+		Vec2 ey = Vec2(m.c, m.d) * half;
+		SDL_Color col = lerpColor(d.colorStart, d.colorEnd, t);
+		if (square) {
+			Vec2 p0 = c - ex - ey;
+			Vec2 p1 = c + ex - ey;
+			Vec2 p2 = c + ex + ey;
+			Vec2 p3 = c - ex + ey;
+			vert[0] = { { p0.x, p0.y }, col, { 0.0f, 0.0f } };
+			vert[1] = { { p1.x, p1.y }, col, { 1.0f, 0.0f } };
+			vert[2] = { { p2.x, p2.y }, col, { 1.0f, 1.0f } };
+			vert[3] = { { p3.x, p3.y }, col, { 0.0f, 1.0f } };
+			vert += 4;
+		} else {
+			Vec2 p0 = c - ey;
+			Vec2 p1 = c + ex + ey;
+			Vec2 p2 = c - ex + ey;
+			vert[0] = { { p0.x, p0.y }, col, { 0.5f, 0.0f } };
+			vert[1] = { { p1.x, p1.y }, col, { 1.0f, 1.0f } };
+			vert[2] = { { p2.x, p2.y }, col, { 0.0f, 1.0f } };
+			vert += 3;
+		}
+		drawn++;
+	}
+	Span<const SDL_Vertex> vertices(d.vertices.data(),
+		drawn * (square ? 4 : 3));
+	Span<const int> indices = square
+		? Span<const int>(d.quadIndices.data(), drawn * 6)
+		: Span<const int>();
+	graphics::geometry(texture, vertices, indices);
+}
+
+void ParticleSystem::emit(std::size_t count) {
+	this->data->spawn(count);
+}
+void ParticleSystem::start() {
+	this->data->active = true;
+}
+void ParticleSystem::stop() {
+	this->data->active = false;
+	this->data->emitPending = 0.0f;
+}
+bool ParticleSystem::isActive() const {
+	return this->data->active;
+}
+void ParticleSystem::reset() {
+	this->data->count = 0;
+	this->data->emitPending = 0.0f;
+}
+
+std::size_t ParticleSystem::getCount() const {
+	return this->data->count;
+}
+std::size_t ParticleSystem::getCapacity() const {
+	return this->data->capacity;
+}
+
+void ParticleSystem::setEmissionRate(float perSecond) {
+	this->data->emissionRate = perSecond;
+}
+void ParticleSystem::setPosition(float x, float y) {
+	this->data->x = x;
+	this->data->y = y;
+}
+void ParticleSystem::setAreaSpread(float width, float height) {
+	this->data->areaWidth = width;
+	this->data->areaHeight = height;
+}
+void ParticleSystem::setDirection(float radians) {
+	this->data->direction = radians;
+}
+void ParticleSystem::setSpread(float radians) {
+	this->data->spread = radians;
+}
+void ParticleSystem::setSpeed(float min, float max) {
+	this->data->speed = { min, max };
+}
+void ParticleSystem::setParticleLifetime(float min, float max) {
+	this->data->life = { min, max };
+}
+void ParticleSystem::setLinearAcceleration(float x, float y) {
+	this->data->accelX = x;
+	this->data->accelY = y;
+}
+void ParticleSystem::setLinearDamping(float damping) {
+	this->data->damping = damping;
+}
+void ParticleSystem::setSizes(float start, float end) {
+	this->data->sizeStart = start;
+	this->data->sizeEnd = end;
+}
+void ParticleSystem::setColors(Color start, Color end) {
+	this->data->colorStart = start;
+	this->data->colorEnd = end;
+}
+void ParticleSystem::setShape(Shape shape) {
+	this->data->shape = shape;
+}
+void ParticleSystem::setImage(std::optional<Image> image) {
+	this->data->image = image;
+}
+void ParticleSystem::setParallel(bool parallel) {
+	this->data->parallel = parallel;
+}
+
+}; // namespace Astrum
@@ -0,0 +1,171 @@
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/pixelbuffer.hpp"
+#include "astrum/graphics.hpp"
+#include "astrum/log.hpp"
+#include "astrum/profile.hpp"
+
+namespace Astrum {
+
+static_assert(sizeof(PixelBuffer::Pixel) == 4,
+	"pixels are uploaded as they are");
+
+struct PixelBufferData {
+	int width;
+	int height;
+	std::vector<PixelBuffer::Pixel> pixels;
+	// created on the first upload, once there is a renderer
+	SDL_Texture *texture = nullptr;
+	bool locked = false;
+	// the rows changed since the last upload, empty when equal
+	int dirtyBegin = 0;
+	int dirtyEnd = 0;
+
+	PixelBufferData(int width, int height) : width(std::max(width, 1)),
+		height(std::max(height, 1)),
+		pixels(static_cast<std::size_t>(this->width) * this->height) {
+		resources::track(this, ResourceType::image,
+			this->pixels.size() * sizeof(PixelBuffer::Pixel));
+		this->dirtyEnd = this->height;
+	}
+	PixelBufferData(const PixelBufferData &src) = delete;
+	PixelBufferData &operator=(const PixelBufferData &src) = delete;
+	~PixelBufferData() {
+		resources::untrack(this);
+		if (this->texture == nullptr)
+			return;
+		resources::untrack(this->texture);
+		// otherwise it went with the renderer
+		if (hasInit)
+			SDL_DestroyTexture(this->texture);
+	}
+
+	void markDirty(int begin, int end) {
+		if (this->dirtyBegin >= this->dirtyEnd) {
+			this->dirtyBegin = begin;
+			this->dirtyEnd = end;
+			return;
+		}
+		this->dirtyBegin = std::min(this->dirtyBegin, begin);
+		this->dirtyEnd = std::max(this->dirtyEnd, end);
+	}
+
+	bool createTexture() {
+		SDL_Renderer *renderer = graphics::getRenderer();
+		if (renderer == nullptr)
+			return false;
+		this->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32,
+			SDL_TEXTUREACCESS_STREAMING, this->width, this->height);
+		if (this->texture == nullptr) {
+			log::error("Could not create pixel buffer texture: %s\n",
+				SDL_GetError());
+			return false;
+		}
+		SDL_SetTextureBlendMode(this->texture, SDL_BLENDMODE_BLEND);
+		SDL_SetTextureScaleMode(this->texture, SDL_ScaleModeNearest);
+		graphics::stats.textureCreations++;
+		resources::track(this->texture, ResourceType::texture,
+			this->pixels.size() * sizeof(PixelBuffer::Pixel));
+		// a new texture has nothing in it yet
+		this->dirtyBegin = 0;
+		this->dirtyEnd = this->height;
+		return true;
+	}
+
+	void upload() {
+		if (this->dirtyBegin >= this->dirtyEnd)
+			return;
+		if (this->texture == nullptr && !this->createTexture())
+			return;
+		ASTRUM_PROFILE_SCOPE("PixelBuffer upload");
+		SDL_Rect rows = { 0, this->dirtyBegin, this->width,
+			this->dirtyEnd - this->dirtyBegin };
+		const PixelBuffer::Pixel *first = &this->pixels[
+			static_cast<std::size_t>(this->dirtyBegin) * this->width];
+		if (SDL_UpdateTexture(this->texture, &rows, first,
+			this->width * static_cast<int>(sizeof(PixelBuffer::Pixel))) != 0) {
+			log::error("Could not upload pixel buffer: %s\n", SDL_GetError());
+			return;
+		}
+		graphics::stats.textureUploads++;
+		this->dirtyBegin = this->dirtyEnd = 0;
+	}
+};
+
+PixelBuffer::PixelBuffer(int width, int height)
+	: data(std::make_shared<PixelBufferData>(width, height)) { }
+
+Span<PixelBuffer::Pixel> PixelBuffer::lock() {
+	return this->lock(0, this->data->height);
+}
+
+Span<PixelBuffer::Pixel> PixelBuffer::lock(int firstRow, int rows) {
+	PixelBufferData &d = *this->data;
+	int begin = std::clamp(firstRow, 0, d.height);
+	int end = std::clamp(firstRow + rows, begin, d.height);
+	d.locked = true;
+	if (begin < end)
+		d.markDirty(begin, end);
+	return Span<Pixel>(d.pixels.data() + static_cast<std::size_t>(begin)
+		* d.width, static_cast<std::size_t>(end - begin) * d.width);
+}
+
+void PixelBuffer::unlock() {
+	this->data->locked = false;
+	this->data->upload();
+}
+
+bool PixelBuffer::isLocked() const {
+	return this->data->locked;
+}
+
+PixelBuffer::Pixel PixelBuffer::getPixel(int x, int y) const {
+	const PixelBufferData &d = *this->data;
+	if (x < 0 || y < 0 || x >= d.width || y >= d.height)
+		return Pixel(0, 0, 0, 0);
+	return d.pixels[static_cast<std::size_t>(y) * d.width + x];
+}
+
+void PixelBuffer::setPixel(int x, int y, Pixel pixel) {
+	PixelBufferData &d = *this->data;
+	if (x < 0 || y < 0 || x >= d.width || y >= d.height)
+		return;
+	d.pixels[static_cast<std::size_t>(y) * d.width + x] = pixel;
+	d.markDirty(y, y + 1);
+}
+
+void PixelBuffer::fill(Pixel pixel) {
+	PixelBufferData &d = *this->data;
+	std::fill(d.pixels.begin(), d.pixels.end(), pixel);
+	d.markDirty(0, d.height);
+}
+
+void PixelBuffer::draw(const graphics::DrawParams &params) const {
+	ASTRUM_PROFILE_SCOPE("PixelBuffer::draw");
+	PixelBufferData &d = *this->data;
+	// the first draw needs a texture to draw at all
+	if (d.texture == nullptr)
+		d.upload();
+	if (d.texture != nullptr)
+		graphics::drawTexture(d.texture, d.width, d.height, params);
+}
+
+void PixelBuffer::draw(float x, float y) const {
+	this->draw(graphics::DrawParams(x, y));
+}
+
+int PixelBuffer::getWidth() const {
+	return this->data->width;
+}
+
+int PixelBuffer::getHeight() const {
+	return this->data->height;
+}
+
+}; // namespace Astrum
@@ -0,0 +1,136 @@
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "astrum/constants.hpp"
+#include "astrum/polygon.hpp"
+#include "astrum/graphics.hpp"
+#include "astrum/math.hpp"
+#include "astrum/mesh.hpp"
+#include "astrum/profile.hpp"
+
+namespace Astrum {
+
+struct PolygonData {
+	std::vector<Vec2> points;
+	std::vector<int> triangles;
+	Color color = Color(0xFF, 0xFF, 0xFF, 0xFF);
+	Mesh mesh;
+
+	void rebuildMesh() {
+		std::vector<Mesh::Vertex> vertices(this->points.size());
+		for (std::size_t i = 0; i < this->points.size(); i++)
+			vertices[i] = { this->points[i], Vec2(), this->color };
+		this->mesh.setVertices(vertices);
+		this->mesh.setIndices(this->triangles);
+	}
+};
+
+// whether `p` is inside or on the edge of triangle `a, b, c`, wound the
+// same way as the outline once its area is made positive
+static bool insideTriangle(Vec2 p, Vec2 a, Vec2 b, Vec2 c) {
+	return (b - a).cross(p - a) >= 0.0f && (c - b).cross(p - b) >= 0.0f
+		&& (a - c).cross(p - c) >= 0.0f;
+}
+
+bool Polygon::triangulate(Span<const Vec2> points, std::vector<int> &out) {
+	ASTRUM_PROFILE_SCOPE("Polygon::triangulate");
+	std::size_t n = points.size();
+	if (n < 3)
+		return n == 0;
+	// twice the signed area, so the winding can be made positive
+	float area = 0.0f;
+	for (std::size_t i = 0; i < n; i++)
+		area += points[i].cross(points[(i + 1) % n]);
+	std::vector<int> remaining(n);
+	for (std::size_t i = 0; i < n; i++)
+		remaining[i] = static_cast<int>(area >= 0.0f ? i : n - 1 - i);
+
+	std::size_t i = 0;
+	// every vertex checked since the last ear means none are left
+	std::size_t sinceEar = 0;
+	while (remaining.size() > 3) {
+		std::size_t m = remaining.size();
+		if (sinceEar >= m)
+			return false;
+		int prev = remaining[(i + m - 1) % m];
+		int cur = remaining[i % m];
+		int next = remaining[(i + 1) % m];
+		Vec2 a = points[prev];
+		Vec2 b = points[cur];
+		Vec2 c = points[next];
+		float turn = (b - a).cross(c - b);
+		bool ear = turn > 0.0f;
+		for (std::size_t j = 0; ear && j < m; j++) {
+			int other = remaining[j];
+			if (other == prev || other == cur || other == next)
+				continue;
+			Vec2 p = points[other];
+			// a point shared with the ear doesn't block it
+			if (p == a || p == b || p == c)
+				continue;
+			if (insideTriangle(p, a, b, c))
+				ear = false;
+		}
+		if (ear || turn == 0.0f) {
+			// a straight or folded-back vertex adds no area, so just drop it
+			if (ear)
+				out.insert(out.end(), { prev, cur, next });
+			remaining.erase(remaining.begin() + i % m);
+			sinceEar = 0;
+			i = i % m;
+			if (i > 0)
+				i--;
+		} else {
+			i = (i + 1) % m;
+			sinceEar++;
+		}
+	}
+	out.insert(out.end(), { remaining[0], remaining[1], remaining[2] });
+	return true;
+}
+
+Polygon::Polygon() : data(std::make_shared<PolygonData>()) { }
+Polygon::Polygon(Span<const Vec2> points, Color color) : Polygon() {
+	this->data->color = color;
+	this->setPoints(points);
+}
+
+bool Polygon::setPoints(Span<const Vec2> points) {
+	PolygonData &d = *this->data;
+	d.points.assign(points.begin(), points.end());
+	d.triangles.clear();
+	bool whole = triangulate(points, d.triangles);
+	d.rebuildMesh();
+	return whole;
+}
+
+const std::vector<Vec2> &Polygon::getPoints() const {
+	return this->data->points;
+}
+
+const std::vector<int> &Polygon::getTriangles() const {
+	return this->data->triangles;
+}
+
+Color Polygon::getColor() const {
+	return this->data->color;
+}
+
+void Polygon::setColor(Color color) {
+	this->data->color = color;
+	this->data->rebuildMesh();
+}
+
+void Polygon::draw(const graphics::DrawParams &params) const {
+	// with no indices, a mesh would take every three points as a triangle
+	if (!this->data->triangles.empty())
+		this->data->mesh.draw(params);
+}
+
+void Polygon::draw(float x, float y) const {
+	this->draw(graphics::DrawParams(x, y));
+}
+
+}; // namespace Astrum
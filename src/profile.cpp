@@ -0,0 +1,148 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sdl.hpp"
+#include "astrum/profile.hpp"
+#include "astrum/log.hpp"
+
+namespace Astrum {
+
+namespace profile {
+
+	namespace {
+		struct Event {
+			const char *name;
+			std::uint64_t start;
+			std::uint64_t end;
+		};
+
+		constexpr std::size_t CHUNKS = EVENTS_PER_THREAD / EVENTS_PER_CHUNK;
+		static_assert(EVENTS_PER_THREAD % EVENTS_PER_CHUNK == 0,
+			"EVENTS_PER_THREAD must be a multiple of EVENTS_PER_CHUNK");
+
+		// written only by its own thread; `count` is published after the
+		// event and its chunk, so `dump` can read up to it from any thread
+		struct ThreadBuffer {
+			std::unique_ptr<Event[]> chunks[CHUNKS];
+			std::atomic<std::size_t> count { 0 };
+			int tid;
+			bool isMain;
+
+			Event &at(std::size_t idx) const {
+				return this->chunks[idx / EVENTS_PER_CHUNK][idx % EVENTS_PER_CHUNK];
+			}
+		};
+
+		// buffers outlive their threads, so detached timer threads can
+		// still be dumped after they finish; chunks are kept after `clear`
+		// and reused
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		std::mutex buffersMutex;
+		std::atomic<std::uint64_t> dropped { 0 };
+		const auto epoch = std::chrono::steady_clock::now();
+		// static initialization runs on the main thread
+		const std::thread::id mainThread = std::this_thread::get_id();
+
+		thread_local ThreadBuffer *threadBuffer = nullptr;
+	};
+
+	static ThreadBuffer *registerThread() {
+		auto buffer = std::make_unique<ThreadBuffer>();
+		buffer->isMain = std::this_thread::get_id() == mainThread;
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer->tid = static_cast<int>(buffers.size()) + 1;
+		buffers.push_back(std::move(buffer));
+		return buffers.back().get();
+	}
+
+	std::uint64_t now() {
+		auto elapsed = std::chrono::steady_clock::now() - epoch;
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+			.count();
+	}
+
+	void record(const char *name, std::uint64_t start, std::uint64_t end) {
+		if (threadBuffer == nullptr)
+			threadBuffer = registerThread();
+		std::size_t idx = threadBuffer->count.load(std::memory_order_relaxed);
+		if (idx >= EVENTS_PER_THREAD) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		std::unique_ptr<Event[]> &chunk = threadBuffer->chunks[
+			idx / EVENTS_PER_CHUNK];
+		if (chunk == nullptr)
+			chunk = std::make_unique<Event[]>(EVENTS_PER_CHUNK);
+		threadBuffer->at(idx) = { name, start, end };
+		threadBuffer->count.store(idx + 1, std::memory_order_release);
+	}
+
+	static void writeEscaped(std::string &out, const char *str) {
+		for (; *str != '\0'; str++) {
+			if (*str == '"' || *str == '\\')
+				out += '\\';
+			out += *str;
+		}
+	}
+
+	bool dump(const std::filesystem::path &path) {
+		std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		char line[128];
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (const auto &buffer : buffers) {
+			std::size_t count = buffer->count.load(std::memory_order_acquire);
+			int len = std::snprintf(line, sizeof(line),
+				"\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\","
+				"\"args\":{\"name\":\"%s\"}},", buffer->tid,
+				buffer->isMain ? "main" : "worker");
+			out.append(line, len);
+			for (std::size_t i = 0; i < count; i++) {
+				const Event &event = buffer->at(i);
+				out += "\n{\"ph\":\"X\",\"pid\":1,\"name\":\"";
+				writeEscaped(out, event.name);
+				// timestamps are in microseconds
+				len = std::snprintf(line, sizeof(line),
+					"\",\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},", buffer->tid,
+					event.start / 1000.0, (event.end - event.start) / 1000.0);
+				out.append(line, len);
+			}
+		}
+		// drop the trailing comma
+		if (out.back() == ',')
+			out.pop_back();
+		out += "\n]}\n";
+
+		SDL_RWops *file = SDL_RWFromFile(path.string().c_str(), "wb");
+		if (file == nullptr) {
+			log::error("Could not write profile to %s: %s\n",
+				path.string().c_str(), SDL_GetError());
+			return false;
+		}
+		std::size_t written = SDL_RWwrite(file, out.data(), 1, out.size());
+		SDL_RWclose(file);
+		return written == out.size();
+	}
+
+	void clear() {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (const auto &buffer : buffers)
+			buffer->count.store(0, std::memory_order_relaxed);
+		dropped = 0;
+	}
+
+	std::uint64_t getDroppedCount() {
+		return dropped;
+	}
+
+};
+
+}; // namespace Astrum
@@ -0,0 +1,366 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdexcept>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/replay.hpp"
+#include "astrum/astrum.hpp"
+#include "astrum/log.hpp"
+#include "astrum/math.hpp"
+
+namespace Astrum {
+
+namespace replay {
+
+	namespace {
+		const char MAGIC[8] = { 'A', 'S', 'T', 'R', 'R', 'E', 'C', '1' };
+		const char TAG_FRAME = 'F';
+		const char TAG_EVENT = 'E';
+		const char TAG_SEED = 'S';
+		const char TAG_GAMEPAD = 'P';
+		// flush the write buffer once it gets this large
+		const std::size_t FLUSH_SIZE = 64 * 1024;
+
+		SDL_RWops *recordFile = nullptr;
+		std::vector<unsigned char> writeBuffer;
+
+		struct Frame {
+			double dt;
+			std::size_t firstEvent;
+			std::size_t eventCount;
+		};
+
+		bool replaying = false;
+		std::vector<Frame> frames;
+		std::vector<SDL_Event> events;
+		std::vector<std::string> droppedFiles;
+		std::vector<unsigned> seeds;
+
+		struct GamepadRecord {
+			SDL_JoystickID id;
+			std::vector<float> axes;
+			std::uint32_t buttons;
+		};
+
+		std::vector<GamepadRecord> gamepads;
+		std::size_t frameIdx = 0;
+		std::size_t eventIdx = 0;
+		std::size_t eventEnd = 0;
+		std::size_t dropIdx = 0;
+		std::size_t seedIdx = 0;
+		std::size_t gamepadIdx = 0;
+		std::vector<double> frameTimes;
+	};
+
+	// only the part of the union in use is stored
+	static std::size_t eventSize(Uint32 type) {
+		switch (type) {
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			return sizeof(SDL_KeyboardEvent);
+		case SDL_TEXTEDITING:
+			return sizeof(SDL_TextEditingEvent);
+		case SDL_TEXTINPUT:
+			return sizeof(SDL_TextInputEvent);
+		case SDL_MOUSEMOTION:
+			return sizeof(SDL_MouseMotionEvent);
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+			return sizeof(SDL_MouseButtonEvent);
+		case SDL_MOUSEWHEEL:
+			return sizeof(SDL_MouseWheelEvent);
+		case SDL_WINDOWEVENT:
+			return sizeof(SDL_WindowEvent);
+		case SDL_DROPFILE:
+			return sizeof(SDL_DropEvent);
+		default:
+			return sizeof(SDL_Event);
+		}
+	}
+
+	static void put(const void *src, std::size_t len) {
+		auto bytes = static_cast<const unsigned char *>(src);
+		writeBuffer.insert(writeBuffer.end(), bytes, bytes + len);
+	}
+
+	static void flush() {
+		if (recordFile == nullptr || writeBuffer.empty())
+			return;
+		SDL_RWwrite(recordFile, writeBuffer.data(), 1, writeBuffer.size());
+		writeBuffer.clear();
+	}
+
+	static void startRecordingWithSeed(std::filesystem::path path,
+		unsigned seed) {
+		recordFile = SDL_RWFromFile(path.string().c_str(), "wb");
+		if (recordFile == nullptr) {
+			log::error("Could not open %s for recording: %s\n",
+				path.string().c_str(), SDL_GetError());
+			return;
+		}
+		writeBuffer.reserve(FLUSH_SIZE + sizeof(SDL_Event) * 2);
+		put(MAGIC, sizeof(MAGIC));
+		std::uint32_t s = seed;
+		put(&s, sizeof(s));
+	}
+
+	bool startRecording(std::filesystem::path path) {
+		if (recordFile != nullptr)
+			return true;
+		math::InitMath();
+		startRecordingWithSeed(path, math::getSeed());
+		return recordFile != nullptr;
+	}
+
+	void stopRecording() {
+		if (recordFile == nullptr)
+			return;
+		flush();
+		SDL_RWclose(recordFile);
+		recordFile = nullptr;
+		writeBuffer = std::vector<unsigned char>();
+	}
+
+	bool isRecording() {
+		return recordFile != nullptr;
+	}
+
+	void recordFrame(double dt) {
+		if (recordFile == nullptr)
+			return;
+		if (writeBuffer.size() >= FLUSH_SIZE)
+			flush();
+		writeBuffer.push_back(TAG_FRAME);
+		put(&dt, sizeof(dt));
+	}
+
+	void recordEvent(const SDL_Event &e) {
+		if (recordFile == nullptr)
+			return;
+		std::uint8_t size = static_cast<std::uint8_t>(eventSize(e.type));
+		writeBuffer.push_back(TAG_EVENT);
+		put(&size, sizeof(size));
+		if (e.type == SDL_CONTROLLERDEVICEADDED
+			|| e.type == SDL_JOYDEVICEADDED) {
+			// the device index means nothing on another machine, so store
+			// the instance id the device's other events will use
+			SDL_Event added = e;
+			if (e.type == SDL_CONTROLLERDEVICEADDED)
+				added.cdevice.which = SDL_JoystickGetDeviceInstanceID(
+					e.cdevice.which);
+			else
+				added.jdevice.which = SDL_JoystickGetDeviceInstanceID(
+					e.jdevice.which);
+			put(&added, size);
+		} else {
+			put(&e, size);
+		}
+		if (e.type == SDL_DROPFILE) {
+			std::uint32_t len = e.drop.file == nullptr ? 0
+				: std::strlen(e.drop.file);
+			put(&len, sizeof(len));
+			put(e.drop.file, len);
+		}
+	}
+
+	void recordGamepad(SDL_JoystickID id, const float *axes,
+		std::size_t count, std::uint32_t buttons) {
+		if (recordFile == nullptr)
+			return;
+		std::uint8_t n = static_cast<std::uint8_t>(count);
+		writeBuffer.push_back(TAG_GAMEPAD);
+		put(&id, sizeof(id));
+		put(&n, sizeof(n));
+		put(axes, n * sizeof(float));
+		put(&buttons, sizeof(buttons));
+	}
+
+	static void loadRecording(std::filesystem::path path) {
+		SDL_RWops *rw = SDL_RWFromFile(path.string().c_str(), "rb");
+		if (rw == nullptr) {
+			log::error("Could not open recording %s: %s\n",
+				path.string().c_str(), SDL_GetError());
+			throw std::runtime_error("Failed to open recording");
+		}
+		Sint64 fileSize = SDL_RWsize(rw);
+		std::vector<unsigned char> data(fileSize > 0 ? fileSize : 0);
+		std::size_t read = SDL_RWread(rw, data.data(), 1, data.size());
+		SDL_RWclose(rw);
+
+		std::size_t pos = 0;
+		auto take = [&](void *dst, std::size_t len) {
+			if (pos + len > read)
+				throw std::runtime_error("Truncated recording");
+			std::memcpy(dst, data.data() + pos, len);
+			pos += len;
+		};
+
+		char magic[sizeof(MAGIC)];
+		std::uint32_t seed;
+		take(magic, sizeof(magic));
+		if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+			throw std::runtime_error("Not an Astrum recording");
+		take(&seed, sizeof(seed));
+
+		while (pos < read) {
+			char tag;
+			take(&tag, 1);
+			if (tag == TAG_FRAME) {
+				Frame frame;
+				take(&frame.dt, sizeof(frame.dt));
+				frame.firstEvent = events.size();
+				frame.eventCount = 0;
+				frames.push_back(frame);
+			} else if (tag == TAG_EVENT) {
+				std::uint8_t size;
+				take(&size, sizeof(size));
+				if (size > sizeof(SDL_Event) || frames.empty())
+					throw std::runtime_error("Corrupt recording");
+				SDL_Event e;
+				std::memset(&e, 0, sizeof(e));
+				take(&e, size);
+				if (e.type == SDL_DROPFILE) {
+					std::uint32_t len;
+					take(&len, sizeof(len));
+					std::string file(len, '\0');
+					take(file.data(), len);
+					droppedFiles.push_back(file);
+					e.drop.file = nullptr;
+				}
+				events.push_back(e);
+				frames.back().eventCount++;
+			} else if (tag == TAG_GAMEPAD) {
+				GamepadRecord pad;
+				std::uint8_t n;
+				take(&pad.id, sizeof(pad.id));
+				take(&n, sizeof(n));
+				pad.axes.resize(n);
+				take(pad.axes.data(), n * sizeof(float));
+				take(&pad.buttons, sizeof(pad.buttons));
+				gamepads.push_back(std::move(pad));
+			} else if (tag == TAG_SEED) {
+				std::uint32_t s;
+				take(&s, sizeof(s));
+				seeds.push_back(s);
+			} else {
+				throw std::runtime_error("Corrupt recording");
+			}
+		}
+
+		frameTimes.reserve(frames.size());
+		math::randomseed(seed);
+		ASTRUM_LOG_INFO("Replaying %zu frames and %zu events from %s\n",
+			frames.size(), events.size(), path.string().c_str());
+	}
+
+	void InitReplay(const Config &conf) {
+		if (!conf.replayInput.empty()) {
+			loadRecording(conf.replayInput);
+			replaying = true;
+		}
+		if (!conf.recordInput.empty())
+			startRecordingWithSeed(conf.recordInput, math::getSeed());
+	}
+
+	void QuitReplay() {
+		stopRecording();
+	}
+
+	bool isReplaying() {
+		return replaying;
+	}
+
+	bool nextFrame(double realDt, double &dt) {
+		if (frameIdx > 0)
+			frameTimes.push_back(realDt);
+		if (frameIdx >= frames.size()) {
+			double total = 0.0;
+			for (double t : frameTimes)
+				total += t;
+			ASTRUM_LOG_INFO("Replay finished: %zu frames in %.3fs\n",
+				frameTimes.size(), total);
+			replaying = false;
+			return false;
+		}
+		const Frame &frame = frames[frameIdx++];
+		dt = frame.dt;
+		eventIdx = frame.firstEvent;
+		eventEnd = frame.firstEvent + frame.eventCount;
+		return true;
+	}
+
+	bool pollEvent(SDL_Event *e) {
+		if (!replaying || eventIdx >= eventEnd)
+			return false;
+		*e = events[eventIdx++];
+		// the event handler frees dropped file names
+		if (e->type == SDL_DROPFILE)
+			e->drop.file = SDL_strdup(droppedFiles[dropIdx++].c_str());
+		return true;
+	}
+
+	bool nextGamepad(SDL_JoystickID id, float *axes, std::size_t count,
+		std::uint32_t &buttons) {
+		// a pad that failed to open while recording has no state
+		if (!replaying || gamepadIdx >= gamepads.size()
+			|| gamepads[gamepadIdx].id != id)
+			return false;
+		const GamepadRecord &pad = gamepads[gamepadIdx++];
+		for (std::size_t i = 0; i < count; i++)
+			axes[i] = i < pad.axes.size() ? pad.axes[i] : 0.0f;
+		buttons = pad.buttons;
+		return true;
+	}
+
+	unsigned filterSeed(unsigned seed) {
+		if (replaying && seedIdx < seeds.size())
+			return seeds[seedIdx++];
+		if (recordFile != nullptr) {
+			std::uint32_t s = seed;
+			writeBuffer.push_back(TAG_SEED);
+			put(&s, sizeof(s));
+		}
+		return seed;
+	}
+
+	std::size_t getFrame() {
+		return frameIdx;
+	}
+
+	std::size_t getFrameCount() {
+		return frames.size();
+	}
+
+	const std::vector<double> &getFrameTimes() {
+		return frameTimes;
+	}
+
+	bool saveFrameTimes(std::filesystem::path path) {
+		SDL_RWops *rw = SDL_RWFromFile(path.string().c_str(), "w");
+		if (rw == nullptr) {
+			log::error("Could not open %s: %s\n", path.string().c_str(),
+				SDL_GetError());
+			return false;
+		}
+		std::string out;
+		char line[32];
+		for (double t : frameTimes) {
+			int len = std::snprintf(line, sizeof(line), "%.9f\n", t);
+			out.append(line, len);
+		}
+		bool ok = SDL_RWwrite(rw, out.data(), 1, out.size()) == out.size();
+		SDL_RWclose(rw);
+		return ok;
+	}
+
+};
+
+}; // namespace Astrum
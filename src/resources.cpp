@@ -0,0 +1,290 @@
+#include <cstddef>
+#include <cstdio>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "internals.hpp"
+#include "astrum/resources.hpp"
+#include "astrum/font.hpp"
+#include "astrum/image.hpp"
+#include "astrum/log.hpp"
+
+namespace Astrum {
+
+namespace resources {
+
+	Listeners<ResourceType, std::size_t, std::size_t> overbudget;
+
+	namespace {
+		constexpr std::size_t TYPES = 5;
+
+		struct Entry {
+			ResourceType type;
+			std::size_t bytes;
+			std::string name;
+		};
+
+		struct Registry {
+			std::mutex mutex;
+			std::unordered_map<const void *, Entry> live;
+			std::array<ResourceUsage, TYPES> usage { };
+			std::array<std::size_t, TYPES> budget { };
+			std::array<bool, TYPES> over { };
+		};
+
+		const char *typeNames[TYPES] = {
+			"image", "texture", "font", "cursor", "sound"
+		};
+
+		struct CacheEntry {
+			std::weak_ptr<void> data;
+			// set while preloaded, to keep the data live without users
+			std::shared_ptr<void> preloaded;
+		};
+
+		struct Cache {
+			std::mutex mutex;
+			std::unordered_map<std::string, CacheEntry> entries;
+		};
+	};
+
+	// never destroyed, since resources held in globals outlive everything
+	static Registry &registry() {
+		static Registry *reg = new Registry();
+		return *reg;
+	}
+
+	// never destroyed either, for the same reason
+	static Cache &fileCache() {
+		static Cache *cache = new Cache();
+		return *cache;
+	}
+
+	static std::size_t index(ResourceType type) {
+		return static_cast<std::size_t>(type);
+	}
+
+	// call with the lock held; returns whether the budget was just crossed
+	static bool updateOverBudget(Registry &reg, std::size_t idx) {
+		bool over = reg.budget[idx] != 0 && reg.usage[idx].bytes > reg.budget[idx];
+		bool crossed = over && !reg.over[idx];
+		reg.over[idx] = over;
+		return crossed;
+	}
+
+	void track(const void *key, ResourceType type, std::size_t bytes) {
+		Registry &reg = registry();
+		std::size_t idx = index(type);
+		std::size_t total, budget;
+		{
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			reg.live[key] = Entry { type, bytes, "" };
+			reg.usage[idx].count++;
+			reg.usage[idx].bytes += bytes;
+			if (!updateOverBudget(reg, idx))
+				return;
+			total = reg.usage[idx].bytes;
+			budget = reg.budget[idx];
+		}
+		// outside the lock, since listeners will likely free resources
+		log::warn("%s memory over budget: %zu of %zu bytes\n",
+			typeNames[idx], total, budget);
+		overbudget.dispatch(type, total, budget);
+	}
+
+	void describe(const void *key, const std::string &name) {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		auto it = reg.live.find(key);
+		if (it != reg.live.end())
+			it->second.name = name;
+	}
+
+	static void untrackLocked(Registry &reg, const void *key) {
+		auto it = reg.live.find(key);
+		if (it == reg.live.end())
+			return;
+		std::size_t idx = index(it->second.type);
+		reg.usage[idx].count--;
+		reg.usage[idx].bytes -= it->second.bytes;
+		updateOverBudget(reg, idx);
+		reg.live.erase(it);
+	}
+
+	void moved(const void *from, const void *to) {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		untrackLocked(reg, to);
+		auto it = reg.live.find(from);
+		if (it == reg.live.end())
+			return;
+		Entry entry = std::move(it->second);
+		reg.live.erase(it);
+		reg.live[to] = std::move(entry);
+	}
+
+	void untrack(const void *key) {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		untrackLocked(reg, key);
+	}
+
+	ResourceUsage getUsage(ResourceType type) {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		return reg.usage[index(type)];
+	}
+
+	std::size_t getTotalBytes() {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		std::size_t total = 0;
+		for (const ResourceUsage &usage : reg.usage)
+			total += usage.bytes;
+		return total;
+	}
+
+	std::vector<ResourceInfo> getLive() {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		std::vector<ResourceInfo> out;
+		out.reserve(reg.live.size());
+		for (const auto &[key, entry] : reg.live)
+			out.push_back(ResourceInfo { entry.type, entry.bytes, entry.name });
+		return out;
+	}
+
+	std::size_t getBudget(ResourceType type) {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		return reg.budget[index(type)];
+	}
+
+	void setBudget(ResourceType type, std::size_t bytes) {
+		Registry &reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mutex);
+		reg.budget[index(type)] = bytes;
+		// a budget lowered below the current usage doesn't fire until the
+		// next resource is created
+		reg.over[index(type)] = false;
+	}
+
+	// the same file through different relative paths or symlinks gets the
+	// same key; paths that don't exist are only made lexically normal
+	static std::string normalize(const std::string &path) {
+		std::error_code err;
+		std::filesystem::path full = std::filesystem::weakly_canonical(path, err);
+		if (err)
+			full = std::filesystem::path(path).lexically_normal();
+		return full.generic_string();
+	}
+
+	std::string imageKey(const std::string &path) {
+		return "image:" + normalize(path);
+	}
+
+	std::string fontKey(const std::string &path, int size, int style) {
+		char params[32];
+		std::snprintf(params, sizeof(params), "font:%d:%d:", size, style);
+		return params + normalize(path);
+	}
+
+	std::shared_ptr<void> findCached(const std::string &key) {
+		Cache &cache = fileCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		auto it = cache.entries.find(key);
+		if (it == cache.entries.end())
+			return nullptr;
+		return it->second.data.lock();
+	}
+
+	std::shared_ptr<void> cache(const std::string &key,
+		std::shared_ptr<void> data) {
+		Cache &cache = fileCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		CacheEntry &entry = cache.entries[key];
+		if (std::shared_ptr<void> existing = entry.data.lock())
+			return existing;
+		entry.data = data;
+		return data;
+	}
+
+	static void pin(const std::string &key, std::shared_ptr<void> data) {
+		Cache &cache = fileCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		auto it = cache.entries.find(key);
+		// a font that failed to load was never cached
+		if (it != cache.entries.end())
+			it->second.preloaded = std::move(data);
+	}
+
+	// the data loaded from the file, rather than the handle's own
+	Image preloadImage(const std::string &path) {
+		Image image(path);
+		pin(imageKey(path), image.getData()->shared);
+		return image;
+	}
+
+	Font preloadFont(const std::string &path, int size, int style) {
+		Font font(path, size, Color(0), style);
+		pin(fontKey(path, size, style), font.getData()->shared);
+		return font;
+	}
+
+	void purge() {
+		Cache &cache = fileCache();
+		std::vector<std::shared_ptr<void>> released;
+		{
+			std::lock_guard<std::mutex> lock(cache.mutex);
+			for (auto it = cache.entries.begin(); it != cache.entries.end();) {
+				long users = it->second.data.use_count();
+				if (it->second.preloaded != nullptr) {
+					released.push_back(std::move(it->second.preloaded));
+					it->second.preloaded = nullptr;
+					users--;
+				}
+				// only entries that something else still uses survive
+				if (users <= 0)
+					it = cache.entries.erase(it);
+				else
+					it++;
+			}
+		}
+		// `released` frees what it holds here, outside the lock
+	}
+
+	std::size_t getCachedCount() {
+		Cache &cache = fileCache();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		std::size_t count = 0;
+		for (const auto &[key, entry] : cache.entries) {
+			if (!entry.data.expired())
+				count++;
+		}
+		return count;
+	}
+
+	void dump() {
+		for (std::size_t i = 0; i < TYPES; i++) {
+			ResourceUsage usage = getUsage(static_cast<ResourceType>(i));
+			if (usage.count > 0)
+				log::info("%zu %s resources live, %zu bytes\n", usage.count,
+					typeNames[i], usage.bytes);
+		}
+		for (const ResourceInfo &info : getLive()) {
+			ASTRUM_LOG_DEBUG("  %s, %zu bytes: %s\n",
+				typeNames[index(info.type)], info.bytes,
+				info.name.empty() ? "(unnamed)" : info.name.c_str());
+		}
+	}
+
+};
+
+}; // namespace Astrum
@@ -0,0 +1,374 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/telemetry.hpp"
+#include "astrum/filesystem.hpp"
+#include "astrum/log.hpp"
+
+#ifdef ASTRUM_COUNT_ALLOCATIONS
+// counts every allocation in the program, not just Astrum's own
+static std::atomic<std::uint64_t> allocationCount { 0 };
+
+void *operator new(std::size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (size == 0)
+		size = 1;
+	while (true) {
+		void *ptr = std::malloc(size);
+		if (ptr != nullptr)
+			return ptr;
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+void *operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+#endif
+
+namespace Astrum {
+
+namespace telemetry {
+
+	namespace {
+		// records handed to the writer at once
+		constexpr std::size_t BATCH = 256;
+
+		bool recording = false;
+		Format format = Format::csv;
+		std::filesystem::path path;
+		SDL_RWops *file = nullptr;
+		bool firstRecord = true;
+
+		double countsPerMs = 1.0;
+		Uint64 frameStart = 0;
+		Uint64 phaseStart = 0;
+		std::uint64_t frameCount = 0;
+		std::uint64_t allocationsAtStart = 0;
+		FrameRecord current;
+
+		std::vector<float> frameTimes;
+		Summary lastSummary;
+		double hitchThreshold = 100.0 / 3.0;
+
+		// filled by the main thread, swapped with `writing` by the writer
+		std::vector<FrameRecord> pending;
+		std::vector<FrameRecord> writing;
+		std::mutex batchMutex;
+		std::condition_variable batchReady;
+		bool writerStop = false;
+		std::thread writer;
+	};
+
+	static std::uint64_t allocationsSoFar() {
+#ifdef ASTRUM_COUNT_ALLOCATIONS
+		return allocationCount.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+
+	static void writeRecords(const std::vector<FrameRecord> &records) {
+		std::string out;
+		out.reserve(records.size() * 128);
+		char line[256];
+		for (const FrameRecord &rec : records) {
+			int len;
+			if (format == Format::csv) {
+				len = std::snprintf(line, sizeof(line),
+					"%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%u,%u,%u,%u,%llu\n",
+					(unsigned long long) rec.frame, rec.frameTime,
+					rec.eventsTime, rec.updateTime, rec.drawTime,
+					rec.presentTime, rec.events, rec.drawCalls,
+					rec.textureUploads, rec.textRasterizations,
+					(unsigned long long) rec.allocations);
+			} else {
+				len = std::snprintf(line, sizeof(line),
+					"%s{\"frame\":%llu,\"frameMs\":%.3f,\"eventsMs\":%.3f,"
+					"\"updateMs\":%.3f,\"drawMs\":%.3f,\"presentMs\":%.3f,"
+					"\"events\":%u,\"drawCalls\":%u,\"textureUploads\":%u,"
+					"\"textRasterizations\":%u,\"allocations\":%llu}",
+					firstRecord ? "\n" : ",\n",
+					(unsigned long long) rec.frame, rec.frameTime,
+					rec.eventsTime, rec.updateTime, rec.drawTime,
+					rec.presentTime, rec.events, rec.drawCalls,
+					rec.textureUploads, rec.textRasterizations,
+					(unsigned long long) rec.allocations);
+				firstRecord = false;
+			}
+			out.append(line, std::min<std::size_t>(len, sizeof(line) - 1));
+		}
+		SDL_RWwrite(file, out.data(), 1, out.size());
+	}
+
+	static void writerLoop() {
+		std::unique_lock<std::mutex> lock(batchMutex);
+		while (true) {
+			batchReady.wait(lock, []() {
+				return writerStop || pending.size() >= BATCH;
+			});
+			writing.swap(pending);
+			bool stopping = writerStop;
+			lock.unlock();
+			writeRecords(writing);
+			writing.clear();
+			lock.lock();
+			if (stopping && pending.empty())
+				break;
+		}
+	}
+
+	static void submit(const FrameRecord &rec) {
+		frameTimes.push_back(rec.frameTime);
+#ifdef __EMSCRIPTEN__
+		pending.push_back(rec);
+		if (pending.size() >= BATCH) {
+			writeRecords(pending);
+			pending.clear();
+		}
+#else
+		std::lock_guard<std::mutex> lock(batchMutex);
+		pending.push_back(rec);
+		if (pending.size() >= BATCH)
+			batchReady.notify_one();
+#endif
+	}
+
+	static Summary summarize() {
+		Summary summary;
+		summary.frames = frameTimes.size();
+		if (frameTimes.empty())
+			return summary;
+		std::vector<float> sorted = frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](double fraction) {
+			std::size_t idx = static_cast<std::size_t>(fraction * sorted.size());
+			return sorted[std::min(idx, sorted.size() - 1)];
+		};
+		double total = 0.0;
+		for (float time : sorted) {
+			total += time;
+			if (time > hitchThreshold)
+				summary.hitches++;
+		}
+		summary.mean = total / sorted.size();
+		summary.p50 = percentile(0.50);
+		summary.p95 = percentile(0.95);
+		summary.p99 = percentile(0.99);
+		summary.max = sorted.back();
+		return summary;
+	}
+
+	static void writeSummary(const Summary &summary) {
+		std::filesystem::path summaryPath = path.parent_path()
+			/ (path.stem().string() + "-summary.json");
+		SDL_RWops *out = SDL_RWFromFile(summaryPath.string().c_str(), "wb");
+		if (out == nullptr) {
+			log::error("Could not create %s: %s\n",
+				summaryPath.string().c_str(), SDL_GetError());
+			return;
+		}
+		char text[1024];
+		int len = std::snprintf(text, sizeof(text),
+			"{\n"
+			"\t\"platform\": \"%s\",\n"
+			"\t\"cpuCount\": %d,\n"
+			"\t\"systemRamMb\": %d,\n"
+			"\t\"allocationsCounted\": %s,\n"
+			"\t\"hitchThresholdMs\": %.3f,\n"
+			"\t\"frames\": %zu,\n"
+			"\t\"meanMs\": %.3f,\n"
+			"\t\"p50Ms\": %.3f,\n"
+			"\t\"p95Ms\": %.3f,\n"
+			"\t\"p99Ms\": %.3f,\n"
+			"\t\"maxMs\": %.3f,\n"
+			"\t\"hitches\": %zu\n"
+			"}\n",
+			SDL_GetPlatform(), SDL_GetCPUCount(), SDL_GetSystemRAM(),
+#ifdef ASTRUM_COUNT_ALLOCATIONS
+			"true",
+#else
+			"false",
+#endif
+			hitchThreshold, summary.frames, summary.mean, summary.p50,
+			summary.p95, summary.p99, summary.max, summary.hitches);
+		SDL_RWwrite(out, text, 1, std::min<std::size_t>(len, sizeof(text) - 1));
+		SDL_RWclose(out);
+	}
+
+	void QuitTelemetry() {
+		stop();
+	}
+
+	void frameStarted() {
+		if (recording) {
+			Uint64 now = SDL_GetPerformanceCounter();
+			std::uint64_t allocations = allocationsSoFar();
+			if (frameStart != 0) {
+				current.frame = frameCount++;
+				current.frameTime = (now - frameStart) / countsPerMs;
+				current.drawCalls = graphics::stats.drawCalls;
+				current.textureUploads = graphics::stats.textureUploads;
+				current.textRasterizations =
+					graphics::stats.textRasterizations;
+				current.allocations = allocations - allocationsAtStart;
+				submit(current);
+			}
+			current = FrameRecord();
+			allocationsAtStart = allocations;
+			frameStart = phaseStart = now;
+		}
+	}
+
+	void phaseDone(Phase phase) {
+		if (!recording)
+			return;
+		Uint64 now = SDL_GetPerformanceCounter();
+		double elapsed = (now - phaseStart) / countsPerMs;
+		phaseStart = now;
+		switch (phase) {
+		case Phase::events:
+			current.eventsTime += elapsed;
+			break;
+		case Phase::update:
+			current.updateTime += elapsed;
+			break;
+		case Phase::draw:
+			current.drawTime += elapsed;
+			break;
+		case Phase::present:
+			current.presentTime += elapsed;
+			break;
+		}
+	}
+
+	void eventsHandled(std::uint32_t count) {
+		if (recording)
+			current.events += count;
+	}
+
+	bool start(Format fmt) {
+		if (recording)
+			return true;
+		std::filesystem::path dir = filesystem::getAppDirectory() / "telemetry";
+		std::error_code err;
+		std::filesystem::create_directories(dir, err);
+		char stamp[32];
+		std::time_t now = std::time(nullptr);
+		std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S",
+			std::localtime(&now));
+		path = dir / (std::string("frames-") + stamp
+			+ (fmt == Format::csv ? ".csv" : ".json"));
+		file = SDL_RWFromFile(path.string().c_str(), "wb");
+		if (file == nullptr) {
+			log::error("Could not create %s: %s\n", path.string().c_str(),
+				SDL_GetError());
+			return false;
+		}
+
+		format = fmt;
+		const char *header = format == Format::csv
+			? "frame,frame_ms,events_ms,update_ms,draw_ms,present_ms,events,"
+			"draw_calls,texture_uploads,text_rasterizations,allocations\n"
+			: "[";
+		SDL_RWwrite(file, header, 1, std::char_traits<char>::length(header));
+		firstRecord = true;
+
+		countsPerMs = SDL_GetPerformanceFrequency() / 1000.0;
+		frameStart = 0;
+		frameCount = 0;
+		frameTimes.clear();
+		// an hour at 60 fps
+		frameTimes.reserve(60 * 60 * 60);
+		pending.reserve(BATCH * 2);
+		writing.reserve(BATCH * 2);
+#ifndef __EMSCRIPTEN__
+		writerStop = false;
+		writer = std::thread(writerLoop);
+#endif
+		recording = true;
+		return true;
+	}
+
+	void stop() {
+		if (!recording)
+			return;
+		recording = false;
+#ifndef __EMSCRIPTEN__
+		{
+			std::lock_guard<std::mutex> lock(batchMutex);
+			writerStop = true;
+		}
+		batchReady.notify_one();
+		writer.join();
+#else
+		writeRecords(pending);
+		pending.clear();
+#endif
+		if (format == Format::json)
+			SDL_RWwrite(file, "\n]\n", 1, 3);
+		SDL_RWclose(file);
+		file = nullptr;
+
+		lastSummary = summarize();
+		writeSummary(lastSummary);
+		log::info("Frame times over %zu frames: mean %.2fms, p50 %.2fms, "
+			"p95 %.2fms, p99 %.2fms, max %.2fms, %zu hitches over %.1fms\n",
+			lastSummary.frames, lastSummary.mean, lastSummary.p50,
+			lastSummary.p95, lastSummary.p99, lastSummary.max,
+			lastSummary.hitches, hitchThreshold);
+	}
+
+	bool isRecording() {
+		return recording;
+	}
+
+	std::filesystem::path getPath() {
+		return path;
+	}
+
+	Summary getSummary() {
+		return recording ? summarize() : lastSummary;
+	}
+
+	double getHitchThreshold() {
+		return hitchThreshold;
+	}
+
+	void setHitchThreshold(double ms) {
+		hitchThreshold = ms;
+	}
+
+};
+
+}; // namespace Astrum
@@ -0,0 +1,324 @@
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "sdl.hpp"
+#include "internals.hpp"
+#include "astrum/constants.hpp"
+#include "astrum/tilemap.hpp"
+#include "astrum/image.hpp"
+#include "astrum/log.hpp"
+#include "astrum/math.hpp"
+#include "astrum/profile.hpp"
+
+namespace Astrum {
+
+struct TileMapData {
+	struct Chunk {
+		SDL_Texture *texture = nullptr;
+		bool dirty = true;
+		std::uint64_t lastDrawn = 0;
+	};
+
+	int width;
+	int height;
+	int tileWidth;
+	int tileHeight;
+	int chunkSize;
+	int chunksX;
+	int chunksY;
+	// chunk by chunk, each chunk row by row, so a chunk's tiles are
+	// contiguous; edge chunks are padded with empty tiles
+	std::vector<TileMap::Tile> tiles;
+	std::vector<Chunk> chunks;
+	std::vector<Color> palette;
+	std::optional<Image> tileset;
+	std::size_t cached = 0;
+	std::size_t maxCached = 64;
+	// counts draws, to find the chunks drawn least recently
+	std::uint64_t frame = 0;
+
+	TileMapData(int width, int height, int tileWidth, int tileHeight,
+		int chunkSize) : width(width), height(height), tileWidth(tileWidth),
+		tileHeight(tileHeight), chunkSize(chunkSize),
+		chunksX((width + chunkSize - 1) / chunkSize),
+		chunksY((height + chunkSize - 1) / chunkSize),
+		tiles(static_cast<std::size_t>(chunksX) * chunksY * chunkSize * chunkSize,
+			TileMap::EMPTY),
+		chunks(static_cast<std::size_t>(chunksX) * chunksY) { }
+	TileMapData(const TileMapData &src) = delete;
+	TileMapData &operator=(const TileMapData &src) = delete;
+	~TileMapData() {
+		for (Chunk &chunk : this->chunks)
+			this->release(chunk);
+	}
+
+	bool inside(int x, int y) const {
+		return x >= 0 && y >= 0 && x < this->width && y < this->height;
+	}
+	std::size_t chunkOf(int x, int y) const {
+		return static_cast<std::size_t>(y / this->chunkSize) * this->chunksX
+			+ x / this->chunkSize;
+	}
+	std::size_t indexOf(int x, int y) const {
+		std::size_t local = static_cast<std::size_t>(y % this->chunkSize)
+			* this->chunkSize + x % this->chunkSize;
+		return this->chunkOf(x, y) * this->chunkSize * this->chunkSize + local;
+	}
+
+	void markAllDirty() {
+		for (Chunk &chunk : this->chunks)
+			chunk.dirty = true;
+	}
+
+	void release(Chunk &chunk) {
+		if (chunk.texture == nullptr)
+			return;
+		resources::untrack(chunk.texture);
+		// otherwise it went with the renderer
+		if (hasInit)
+			SDL_DestroyTexture(chunk.texture);
+		chunk.texture = nullptr;
+		chunk.dirty = true;
+		this->cached--;
+	}
+
+	// releases the texture drawn longest ago, unless every texture was
+	// drawn this frame
+	void evictOne() {
+		Chunk *oldest = nullptr;
+		for (Chunk &chunk : this->chunks) {
+			if (chunk.texture != nullptr && chunk.lastDrawn != this->frame
+				&& (oldest == nullptr || chunk.lastDrawn < oldest->lastDrawn))
+				oldest = &chunk;
+		}
+		if (oldest != nullptr)
+			this->release(*oldest);
+	}
+
+	bool createTexture(SDL_Renderer *renderer, Chunk &chunk) {
+		if (this->cached >= this->maxCached)
+			this->evictOne();
+		int w = this->chunkSize * this->tileWidth;
+		int h = this->chunkSize * this->tileHeight;
+		chunk.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+			SDL_TEXTUREACCESS_TARGET, w, h);
+		if (chunk.texture == nullptr) {
+			log::error("Could not create tile chunk texture: %s\n",
+				SDL_GetError());
+			return false;
+		}
+		SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_BLEND);
+		graphics::stats.textureCreations++;
+		resources::track(chunk.texture, ResourceType::texture,
+			static_cast<std::size_t>(w) * h * 4);
+		this->cached++;
+		chunk.dirty = true;
+		return true;
+	}
+
+	void renderChunk(SDL_Renderer *renderer, std::size_t idx) {
+		ASTRUM_PROFILE_SCOPE("TileMap chunk");
+		Chunk &chunk = this->chunks[idx];
+		SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+		Uint8 r = 0, g = 0, b = 0, a = 0;
+		SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+		SDL_BlendMode drawBlend = SDL_BLENDMODE_NONE;
+		SDL_GetRenderDrawBlendMode(renderer, &drawBlend);
+
+		SDL_SetRenderTarget(renderer, chunk.texture);
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+		SDL_RenderClear(renderer);
+
+		SDL_Texture *tiles = nullptr;
+		SDL_BlendMode tilesBlend = SDL_BLENDMODE_BLEND;
+		int columns = 1;
+		if (this->tileset) {
+			tiles = graphics::getTexture(*this->tileset->getData());
+			columns = std::max(this->tileset->getWidth() / this->tileWidth, 1);
+			// tiles don't overlap, so copy them as they are, alpha included
+			if (tiles != nullptr) {
+				SDL_GetTextureBlendMode(tiles, &tilesBlend);
+				SDL_SetTextureBlendMode(tiles, SDL_BLENDMODE_NONE);
+			}
+		}
+
+		const TileMap::Tile *chunkTiles = &this->tiles[idx * this->chunkSize
+			* this->chunkSize];
+		for (int ty = 0; ty < this->chunkSize; ty++) {
+			for (int tx = 0; tx < this->chunkSize; tx++) {
+				TileMap::Tile tile = chunkTiles[ty * this->chunkSize + tx];
+				if (tile == TileMap::EMPTY)
+					continue;
+				SDL_Rect dest = { tx * this->tileWidth, ty * this->tileHeight,
+					this->tileWidth, this->tileHeight };
+				if (this->tileset) {
+					if (tiles == nullptr)
+						continue;
+					int n = tile - 1;
+					SDL_Rect src = { (n % columns) * this->tileWidth,
+						(n / columns) * this->tileHeight, this->tileWidth,
+						this->tileHeight };
+					SDL_RenderCopy(renderer, tiles, &src, &dest);
+				} else {
+					if (tile >= this->palette.size())
+						continue;
+					Color col = this->palette[tile];
+					SDL_SetRenderDrawColor(renderer, col.r, col.g, col.b, col.a);
+					SDL_RenderFillRect(renderer, &dest);
+				}
+				graphics::stats.drawCalls++;
+			}
+		}
+
+		if (tiles != nullptr)
+			SDL_SetTextureBlendMode(tiles, tilesBlend);
+		SDL_SetRenderTarget(renderer, previous);
+		SDL_SetRenderDrawBlendMode(renderer, drawBlend);
+		SDL_SetRenderDrawColor(renderer, r, g, b, a);
+		chunk.dirty = false;
+	}
+};
+
+TileMap::TileMap(int width, int height, int tileWidth, int tileHeight,
+	int chunkSize) : data(std::make_shared<TileMapData>(width, height,
+	tileWidth, tileHeight, chunkSize)) { }
+TileMap::TileMap(Image tileset, int width, int height, int tileWidth,
+	int tileHeight, int chunkSize) : TileMap(width, height, tileWidth,
+	tileHeight, chunkSize) {
+	this->data->tileset = tileset;
+}
+
+TileMap::Tile TileMap::get(int x, int y) const {
+	if (!this->data->inside(x, y))
+		return EMPTY;
+	return this->data->tiles[this->data->indexOf(x, y)];
+}
+
+void TileMap::set(int x, int y, Tile tile) {
+	TileMapData &d = *this->data;
+	if (!d.inside(x, y))
+		return;
+	Tile &current = d.tiles[d.indexOf(x, y)];
+	if (current == tile)
+		return;
+	current = tile;
+	d.chunks[d.chunkOf(x, y)].dirty = true;
+}
+
+void TileMap::fill(Tile tile) {
+	TileMapData &d = *this->data;
+	for (int y = 0; y < d.height; y++) {
+		for (int x = 0; x < d.width; x++)
+			d.tiles[d.indexOf(x, y)] = tile;
+	}
+	d.markAllDirty();
+}
+
+void TileMap::setTileColor(Tile tile, Color color) {
+	TileMapData &d = *this->data;
+	if (tile >= d.palette.size())
+		d.palette.resize(tile + 1);
+	d.palette[tile] = color;
+	d.markAllDirty();
+}
+
+void TileMap::draw(float x, float y) const {
+	ASTRUM_PROFILE_SCOPE("TileMap::draw");
+	TileMapData &d = *this->data;
+	SDL_Renderer *renderer = graphics::getRenderer();
+	Mat3 transform = graphics::getTransform() * Mat3::translation(x, y);
+	if (renderer == nullptr || transform.determinant() == 0.0f)
+		return;
+	Rect view = graphics::getViewBounds();
+
+	// the chunks overlapping the view, once it's mapped back onto the map
+	float chunkW = static_cast<float>(d.chunkSize * d.tileWidth);
+	float chunkH = static_cast<float>(d.chunkSize * d.tileHeight);
+	Rect area = transform.inverse().applyRect(view);
+	int minX = std::max(static_cast<int>(std::floor(area.left() / chunkW)), 0);
+	int minY = std::max(static_cast<int>(std::floor(area.top() / chunkH)), 0);
+	int maxX = std::min(static_cast<int>(std::floor(area.right() / chunkW)),
+		d.chunksX - 1);
+	int maxY = std::min(static_cast<int>(std::floor(area.bottom() / chunkH)),
+		d.chunksY - 1);
+	bool translateOnly = transform.a == 1.0f && transform.b == 0.0f
+		&& transform.c == 0.0f && transform.d == 1.0f;
+
+	d.frame++;
+	for (int cy = minY; cy <= maxY; cy++) {
+		for (int cx = minX; cx <= maxX; cx++) {
+			Rect bounds(cx * chunkW, cy * chunkH, chunkW, chunkH);
+			// rotated maps cover less of the area than its bounds suggest
+			if (!translateOnly && !transform.applyRect(bounds).intersects(view))
+				continue;
+			std::size_t idx = static_cast<std::size_t>(cy) * d.chunksX + cx;
+			TileMapData::Chunk &chunk = d.chunks[idx];
+			chunk.lastDrawn = d.frame;
+			if (chunk.texture == nullptr && !d.createTexture(renderer, chunk))
+				continue;
+			if (chunk.dirty)
+				d.renderChunk(renderer, idx);
+			if (translateOnly) {
+				SDL_FRect dest = { transform.tx + bounds.x,
+					transform.ty + bounds.y, chunkW, chunkH };
+				SDL_RenderCopyF(renderer, chunk.texture, nullptr, &dest);
+				graphics::stats.drawCalls++;
+				continue;
+			}
+			const SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+			Vec2 p[] = { transform.apply(Vec2(bounds.left(), bounds.top())),
+				transform.apply(Vec2(bounds.right(), bounds.top())),
+				transform.apply(Vec2(bounds.right(), bounds.bottom())),
+				transform.apply(Vec2(bounds.left(), bounds.bottom())) };
+			const SDL_Vertex vertices[] = {
+				{ { p[0].x, p[0].y }, white, { 0.0f, 0.0f } },
+				{ { p[1].x, p[1].y }, white, { 1.0f, 0.0f } },
+				{ { p[2].x, p[2].y }, white, { 1.0f, 1.0f } },
+				{ { p[3].x, p[3].y }, white, { 0.0f, 1.0f } },
+			};
+			const int quad[] = { 0, 1, 2, 0, 2, 3 };
+			graphics::geometry(chunk.texture, vertices, quad);
+		}
+	}
+}
+
+void TileMap::invalidate() {
+	this->data->markAllDirty();
+}
+
+int TileMap::getWidth() const {
+	return this->data->width;
+}
+int TileMap::getHeight() const {
+	return this->data->height;
+}
+int TileMap::getTileWidth() const {
+	return this->data->tileWidth;
+}
+int TileMap::getTileHeight() const {
+	return this->data->tileHeight;
+}
+int TileMap::getChunkSize() const {
+	return this->data->chunkSize;
+}
+std::size_t TileMap::getMaxCachedChunks() const {
+	return this->data->maxCached;
+}
+void TileMap::setMaxCachedChunks(std::size_t count) {
+	TileMapData &d = *this->data;
+	d.maxCached = count;
+	while (d.cached > d.maxCached) {
+		std::size_t before = d.cached;
+		d.evictOne();
+		if (d.cached == before)
+			break;
+	}
+}
+
+}; // namespace Astrum
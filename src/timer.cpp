@@ -7,7 +7,9 @@
 
 #include "sdl.hpp"
 #include "astrum/astrum.hpp"
+#include "internals.hpp"
 #include "astrum/timer.hpp"
+#include "astrum/profile.hpp"
 
 namespace Astrum {
 
@@ -55,7 +57,10 @@ namespace timer {
 				if (term)
 					break;
 
-				cb();
+				{
+					ASTRUM_PROFILE_SCOPE("timer callback");
+					cb();
+				}
 				auto end = std::chrono::high_resolution_clock::now();
 				remaining = interval - std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
 			} while (repeat);
@@ -87,6 +92,10 @@ namespace timer {
 		return dt;
 	}
 
+	void setDelta(double delta) {
+		dt = delta;
+	}
+
 	double deltatime() {
 		return dt;
 	}
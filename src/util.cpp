@@ -2,7 +2,6 @@
 #include <cstdarg>
 #include <cstdio>
 #include <stdexcept>
-#include <memory>
 
 #include "astrum/constants.hpp"
 #include "astrum/util.hpp"
@@ -11,7 +10,7 @@ namespace Astrum {
 
 namespace util {
 
-	std::string strformat(std::string format, ...) {
+	std::string strformat(const char *format, ...) {
 		std::va_list args;
 		va_start(args, format);
 		std::string out = vstrformat(format, args);
@@ -19,19 +18,21 @@ namespace util {
 		return out;
 	}
 
-	std::string vstrformat(std::string format, std::va_list args) {
+	std::string vstrformat(const char *format, std::va_list args) {
+		char stackBuf[256];
 		std::va_list tmpArgs;
 		va_copy(tmpArgs, args);
-		// extra space for NULL terminator
-		int size_i = std::vsnprintf(nullptr, 0, format.c_str(), tmpArgs) + 1;
+		int size = std::vsnprintf(stackBuf, sizeof(stackBuf), format, tmpArgs);
 		va_end(tmpArgs);
-		if (size_i < 0)
+		if (size < 0)
 			throw std::runtime_error("Error during formatting.");
-		auto size = static_cast<size_t>(size_i);
-		auto buf = std::make_unique<char[]>(size);
-		std::vsnprintf(buf.get(), size, format.c_str(), args);
-		// exclude final NULL terminator in string
-		return std::string(buf.get(), buf.get() + size - 1);
+		if (static_cast<size_t>(size) < sizeof(stackBuf))
+			return std::string(stackBuf, size);
+		// too long for the stack; format again straight into the string,
+		// with extra space for the NULL terminator
+		std::string out(size, '\0');
+		std::vsnprintf(out.data(), size + 1, format, args);
+		return out;
 	}
 
 }
@@ -30,6 +30,7 @@ namespace window {
 					| (conf.windowFullscreen ? SDL_WINDOW_FULLSCREEN : 0)
 					| (conf.windowResizable  ? SDL_WINDOW_RESIZABLE  : 0)
 					| (conf.windowBorderless ? SDL_WINDOW_BORDERLESS : 0)
+					| (conf.headless         ? SDL_WINDOW_HIDDEN     : 0)
 			);
 		}
 
@@ -0,0 +1,67 @@
+// Prints binary log files written by `Astrum::log::openFile` as text, in the
+// same layout as the text log format.
+
+#include <astrum/log.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+static const char *categoryNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static std::uint64_t readLE(const unsigned char *bytes, int count) {
+	std::uint64_t value = 0;
+	for (int i = count - 1; i >= 0; i--)
+		value = (value << 8) | bytes[i];
+	return value;
+}
+
+static bool decode(const char *path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		std::fprintf(stderr, "%s: could not open file\n", path);
+		return false;
+	}
+
+	unsigned char header[16];
+	if (!in.read(reinterpret_cast<char *>(header), sizeof(header))
+		|| std::memcmp(header, Astrum::log::LOG_FILE_MAGIC, 8) != 0) {
+		std::fprintf(stderr, "%s: not a binary log file\n", path);
+		return false;
+	}
+	std::time_t opened = static_cast<std::time_t>(readLE(header + 8, 8));
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S",
+		std::localtime(&opened));
+	std::printf("# log opened %s\n", stamp);
+
+	unsigned char record[7];
+	std::string message;
+	while (in.read(reinterpret_cast<char *>(record), sizeof(record))) {
+		unsigned category = record[0];
+		std::uint32_t ticks = readLE(record + 1, 4);
+		std::size_t length = readLE(record + 5, 2);
+		message.resize(length);
+		if (!in.read(message.data(), length)) {
+			std::fprintf(stderr, "%s: truncated record\n", path);
+			return false;
+		}
+		std::printf("[%10.3f] %s: %s\n", ticks / 1000.0,
+			category < 4 ? categoryNames[category] : "?", message.c_str());
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s file.alog...\n", argv[0]);
+		return 2;
+	}
+	bool ok = true;
+	for (int i = 1; i < argc; i++)
+		ok = decode(argv[i]) && ok;
+	return ok ? 0 : 1;
+}